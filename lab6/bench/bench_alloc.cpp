@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+
+#include "dungeon.hpp"
+#include "factory.hpp"
+#include "npc.hpp"
+#include "observer.hpp"
+
+// Counts every heap allocation made by this executable, so the benchmarks
+// below can report allocations per operation next to their timings. The
+// replacement is global, so this file is built on its own as
+// lab6_bench_alloc rather than into lab6_bench.
+static std::atomic<std::size_t> g_allocs{0};
+
+void* operator new(std::size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+// names longer than the small-string buffer, so every copy of one allocates
+static void fillWorld(Dungeon &d, std::size_t n, double side, unsigned seed) {
+    static const char *types[] = {"Orc", "Bear", "Squirrel"};
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coord(0.0, side);
+    for (std::size_t i = 0; i < n; ++i)
+        d.addNPC(NPCFactory::create(types[rng() % 3], "wandering_creature_" + std::to_string(i), coord(rng), coord(rng), d.pool()));
+}
+
+// allocations made by one combat round (grid, scratch buffers, events)
+static void BM_CombatRoundAllocs(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    std::size_t allocs = 0, rounds = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        Dungeon d;
+        fillWorld(d, n, 500.0, 3);
+        const std::size_t before = g_allocs.load(std::memory_order_relaxed);
+        state.ResumeTiming();
+        d.runCombat(10.0);
+        allocs += g_allocs.load(std::memory_order_relaxed) - before;
+        ++rounds;
+    }
+    state.counters["allocs_per_round"] = static_cast<double>(allocs) / static_cast<double>(rounds);
+}
+BENCHMARK(BM_CombatRoundAllocs)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+struct NameLengthObserver : IObserver {
+    std::size_t bytes = 0;
+    void onDeath(const DeathEvent &ev, const INameSource &names) override {
+        bytes += names.nameOf(ev.killer).size() + names.nameOf(ev.victim).size();
+    }
+};
+
+// allocations per round in a long-lived dungeon with a subscribed observer:
+// a few hunters arrive between rounds (not counted) and kill someone. Once
+// the scratch buffers have grown, events carry handles and the observer
+// reads names in place, so a round should not allocate at all.
+static void BM_SteadyRoundAllocs(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    Dungeon d;
+    auto obs = std::make_shared<NameLengthObserver>();
+    d.events().subscribe(obs);
+    fillWorld(d, n, 500.0, 5);
+    d.runCombat(10.0);
+
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<double> coord(0.0, 500.0);
+    std::size_t allocs = 0, rounds = 0, next = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int k = 0; k < 8; ++k)
+            d.addNPC(NPCFactory::create("Orc", "arriving_hunter_" + std::to_string(next++), coord(rng), coord(rng), d.pool()));
+        const std::size_t before = g_allocs.load(std::memory_order_relaxed);
+        state.ResumeTiming();
+        d.runCombat(10.0);
+        state.PauseTiming();
+        if (rounds++ >= 16) allocs += g_allocs.load(std::memory_order_relaxed) - before;   // after warm-up
+        state.ResumeTiming();
+    }
+    state.counters["allocs_per_round"] = rounds > 16 ? static_cast<double>(allocs) / static_cast<double>(rounds - 16) : 0.0;
+    benchmark::DoNotOptimize(obs->bytes);
+}
+BENCHMARK(BM_SteadyRoundAllocs)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// allocations made by saving and printing a roster; names and types are
+// read in place, so neither should allocate per NPC
+static void BM_SaveAllocs(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    Dungeon d;
+    fillWorld(d, n, 500.0, 4);
+    std::size_t allocs = 0, runs = 0;
+    for (auto _ : state) {
+        const std::size_t before = g_allocs.load(std::memory_order_relaxed);
+        d.saveToFile("bench_alloc_roster.txt");
+        allocs += g_allocs.load(std::memory_order_relaxed) - before;
+        ++runs;
+    }
+    state.counters["allocs_per_npc"] = static_cast<double>(allocs) / static_cast<double>(runs * n);
+    std::remove("bench_alloc_roster.txt");
+}
+BENCHMARK(BM_SaveAllocs)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "distance_kernel.hpp"
+#include "dungeon.hpp"
+#include "factory.hpp"
+#include "npc.hpp"
+
+// Dense map: every candidate lies inside the radius, so the filter does all
+// the work and nothing is skipped early.
+static void BM_InRangeMask(benchmark::State &state) {
+    const auto kernel = static_cast<DistanceKernel>(state.range(0));
+    const std::size_t count = 4096;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(0.0, 50.0);
+    std::vector<double> xs(count), ys(count);
+    for (std::size_t k = 0; k < count; ++k) { xs[k] = coord(rng); ys[k] = coord(rng); }
+    std::vector<std::uint64_t> mask((count + 63) / 64);
+
+    for (auto _ : state) {
+        inRangeMask(kernel, 25.0, 25.0, xs.data(), ys.data(), count, 100.0 * 100.0, mask.data());
+        benchmark::DoNotOptimize(mask.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.SetLabel(distanceKernelName(kernel));
+}
+BENCHMARK(BM_InRangeMask)
+    ->Arg(static_cast<int>(DistanceKernel::Scalar))
+    ->Arg(static_cast<int>(DistanceKernel::SSE2))
+    ->Arg(static_cast<int>(DistanceKernel::AVX2));
+
+// Whole combat round on a crowded corner of the map where most pairs are in
+// range; all three species, so every kind of pair that can fight is tested.
+static void BM_RunCombatDense(benchmark::State &state) {
+    static const char *types[] = {"Orc", "Bear", "Squirrel"};
+    const auto n = static_cast<std::size_t>(state.range(0));
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<double> coord(0.0, 40.0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto d = std::make_unique<Dungeon>();
+        for (std::size_t i = 0; i < n; ++i)
+            d->addNPC(NPCFactory::create(types[i % 3], "s" + std::to_string(i), coord(rng), coord(rng)));
+        state.ResumeTiming();
+        d->runCombat(60.0);
+        state.PauseTiming();
+        d.reset();   // freeing the world is not part of the round
+        state.ResumeTiming();
+    }
+    state.SetLabel(distanceKernelName(activeDistanceKernel()));
+}
+BENCHMARK(BM_RunCombatDense)->Arg(1000)->Arg(4000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
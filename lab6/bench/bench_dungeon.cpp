@@ -0,0 +1,307 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dungeon.hpp"
+#include "factory.hpp"
+#include "movement.hpp"
+#include "npc.hpp"
+#include "observer.hpp"
+
+namespace {
+
+enum Layout { Uniform, Clustered, SingleSpecies, SquirrelHeavy };
+
+const char* layoutName(int layout) {
+    switch (layout) {
+        case Clustered: return "clustered";
+        case SingleSpecies: return "single-species";
+        case SquirrelHeavy: return "squirrel-heavy";
+        default: return "uniform";
+    }
+}
+
+struct Spawn {
+    NPCKind kind;
+    std::string name;
+    double x, y;
+};
+
+// Deterministic roster for a layout:
+//   uniform        - all three kinds spread over the whole map
+//   clustered      - all three kinds packed around a few dozen centres
+//   single-species - Orcs only, spread uniformly; every pair in range fights
+//   squirrel-heavy - 90% Squirrels, the rest Orcs and Bears, spread uniformly
+std::vector<Spawn> makeRoster(std::size_t n, int layout, unsigned seed = 7) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coord(0.0, 500.0);
+    std::normal_distribution<double> spread(0.0, 8.0);
+    std::vector<std::pair<double, double>> centres(32);
+    for (auto &c : centres) c = {coord(rng), coord(rng)};
+
+    auto clamp = [](double v) { return v < 0.0 ? 0.0 : (v > 500.0 ? 500.0 : v); };
+    std::vector<Spawn> roster;
+    roster.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        Spawn s{static_cast<NPCKind>(rng() % kNPCKindCount), "npc_" + std::to_string(i), 0.0, 0.0};
+        if (layout == Clustered) {
+            const auto &c = centres[rng() % centres.size()];
+            s.x = clamp(c.first + spread(rng));
+            s.y = clamp(c.second + spread(rng));
+        } else {
+            s.x = coord(rng);
+            s.y = coord(rng);
+        }
+        if (layout == SingleSpecies) s.kind = NPCKind::Orc;
+        if (layout == SquirrelHeavy && rng() % 10 != 0) s.kind = NPCKind::Squirrel;
+        roster.push_back(std::move(s));
+    }
+    return roster;
+}
+
+void populate(Dungeon &d, const std::vector<Spawn> &roster) {
+    for (const auto &s : roster) d.addNPC(NPCFactory::create(s.kind, s.name, s.x, s.y, d.pool()));
+}
+
+struct CountingObserver : IObserver {
+    std::size_t seen = 0;
+    void onDeath(const DeathEvent &ev, const INameSource &names) override { seen += names.nameOf(ev.victim).size(); }
+};
+
+// every handle is called "victim"
+struct FixedNames : INameSource {
+    std::string_view nameOf(NPCHandle) const noexcept override { return "victim"; }
+};
+
+} // namespace
+
+// One combat round; args are {npc count, range, layout}. Building and
+// freeing the world are excluded from the timing.
+static void BM_Combat(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto range = static_cast<double>(state.range(1));
+    const int layout = static_cast<int>(state.range(2));
+    const auto roster = makeRoster(n, layout);
+
+    std::size_t deaths = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto d = std::make_unique<Dungeon>();
+        populate(*d, roster);
+        state.ResumeTiming();
+        d->runCombat(range);
+        state.PauseTiming();
+        deaths += n - d->size();
+        d.reset();   // freeing the world is not part of the round
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    state.counters["deaths"] = benchmark::Counter(static_cast<double>(deaths), benchmark::Counter::kAvgIterations);
+    state.SetLabel(layoutName(layout));
+}
+BENCHMARK(BM_Combat)
+    ->ArgNames({"n", "range", "layout"})
+    ->ArgsProduct({{1000, 10000, 50000}, {5, 20, 50}, {Uniform, Clustered, SingleSpecies, SquirrelHeavy}})
+    ->Unit(benchmark::kMillisecond);
+
+// Balancing run: combat at `ranges` evenly spaced ranges up to 20, each on
+// a fresh copy of the map (repeated = 1) or all at once with sweepCombat
+// (repeated = 0). Args are {npc count, ranges, repeated}; building and
+// freeing the copies, and freeing the sweep's results, are excluded from
+// the timing.
+static void BM_RangeSweep(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto count = static_cast<std::size_t>(state.range(1));
+    const bool repeated = state.range(2) != 0;
+    const auto roster = makeRoster(n, Uniform);
+    std::vector<double> ranges(count);
+    for (std::size_t k = 0; k < count; ++k) ranges[k] = 20.0 * static_cast<double>(k + 1) / static_cast<double>(count);
+
+    Dungeon d;
+    populate(d, roster);
+    for (auto _ : state) {
+        if (!repeated) {
+            auto sweep = d.sweepCombat(ranges);
+            benchmark::DoNotOptimize(sweep.data());
+            state.PauseTiming();
+            sweep.clear();
+            state.ResumeTiming();
+            continue;
+        }
+        for (double range : ranges) {
+            state.PauseTiming();
+            auto copy = std::make_unique<Dungeon>();
+            populate(*copy, roster);
+            state.ResumeTiming();
+            copy->runCombat(range);
+            state.PauseTiming();
+            copy.reset();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.SetLabel(repeated ? "runCombat per range" : "sweepCombat");
+}
+BENCHMARK(BM_RangeSweep)
+    ->ArgNames({"n", "ranges", "repeated"})
+    ->ArgsProduct({{10000, 50000}, {8, 32}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// Battle to a standstill; args are {npc count, range}. Building and freeing
+// the world are excluded from the timing.
+static void BM_Simulate(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto range = static_cast<double>(state.range(1));
+    const auto roster = makeRoster(n, Uniform);
+
+    std::size_t rounds = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto d = std::make_unique<Dungeon>();
+        populate(*d, roster);
+        state.ResumeTiming();
+        rounds += d->simulate(range).rounds.size();
+        state.PauseTiming();
+        d.reset();
+        state.ResumeTiming();
+    }
+    state.counters["rounds"] = benchmark::Counter(static_cast<double>(rounds), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Simulate)->Args({10000, 20})->Args({50000, 5})->Unit(benchmark::kMillisecond);
+
+// Persistent world of Squirrels (nobody fights) visited by a few hunters
+// per tick; after the first round only the arrivals are dirty. Args are
+// {npc count, arrivals per tick}.
+static void BM_CombatTick(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto arrivals = static_cast<std::size_t>(state.range(1));
+    auto roster = makeRoster(n, Uniform);
+    for (auto &s : roster) s.kind = NPCKind::Squirrel;
+    Dungeon d;
+    populate(d, roster);
+    d.runCombat(10.0);
+
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<double> coord(0.0, 500.0);
+    std::size_t next = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (std::size_t k = 0; k < arrivals; ++k)
+            d.addNPC(NPCFactory::create(static_cast<NPCKind>(rng() % kNPCKindCount),
+                                        "late_" + std::to_string(next++), coord(rng), coord(rng), d.pool()));
+        state.ResumeTiming();
+        d.runCombat(10.0);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * arrivals));
+}
+BENCHMARK(BM_CombatTick)->Args({100000, 10})->Args({100000, 1000})->Unit(benchmark::kMicrosecond);
+
+// Movement tick followed by a combat round in a persistent world; args are
+// {npc count, range}. Every NPC walks, so the whole world is dirty.
+static void BM_MoveAndFight(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto range = static_cast<double>(state.range(1));
+    auto roster = makeRoster(n, Uniform);
+    for (auto &s : roster) s.kind = NPCKind::Squirrel;
+    Dungeon d;
+    populate(d, roster);
+    d.runCombat(range);
+    RandomWalk walk(11);
+
+    for (auto _ : state) {
+        d.move(walk);
+        d.runCombat(range);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+BENCHMARK(BM_MoveAndFight)->Args({100000, 10})->Unit(benchmark::kMillisecond);
+
+// Text roster round trip; bytes are the size of the saved file.
+static void BM_SaveToFile(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    Dungeon d;
+    populate(d, makeRoster(n, Uniform));
+    const std::string path = "bench_save_" + std::to_string(n) + ".txt";
+
+    for (auto _ : state) benchmark::DoNotOptimize(d.saveToFile(path));
+
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    long bytes = 0;
+    if (f) { std::fseek(f, 0, SEEK_END); bytes = std::ftell(f); std::fclose(f); }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * bytes);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_SaveToFile)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadFromFile(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const std::string path = "bench_load_" + std::to_string(n) + ".txt";
+    {
+        Dungeon d;
+        populate(d, makeRoster(n, Uniform));
+        d.saveToFile(path);
+    }
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    long bytes = 0;
+    if (f) { std::fseek(f, 0, SEEK_END); bytes = std::ftell(f); std::fclose(f); }
+
+    Dungeon d;
+    for (auto _ : state) benchmark::DoNotOptimize(d.loadFromFile(path));
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * bytes);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_LoadFromFile)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Factory + addNPC for a whole roster into an empty dungeon.
+static void BM_AddNPC(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto roster = makeRoster(n, Uniform);
+    for (auto _ : state) {
+        Dungeon d;
+        populate(d, roster);
+        benchmark::DoNotOptimize(d.size());
+        state.PauseTiming();
+        d.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+BENCHMARK(BM_AddNPC)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// One event delivered to a growing number of subscribers.
+static void BM_NotifyFanOut(benchmark::State &state) {
+    const auto observers = static_cast<std::size_t>(state.range(0));
+    EventManager em;
+    FixedNames names;
+    em.setNameSource(&names);
+    for (std::size_t i = 0; i < observers; ++i) em.subscribe(std::make_shared<CountingObserver>());
+    const DeathEvent ev{NPCHandle::make(0, 1), NPCHandle::make(1, 1), 1.0, 2.0};
+
+    for (auto _ : state) em.notify(ev);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * observers));
+}
+BENCHMARK(BM_NotifyFanOut)->RangeMultiplier(4)->Range(1, 256);
+
+// A round's worth of events published as one batch, synchronously.
+static void BM_PublishBatch(benchmark::State &state) {
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    EventManager em;
+    FixedNames names;
+    em.setNameSource(&names);
+    for (int i = 0; i < 4; ++i) em.subscribe(std::make_shared<CountingObserver>());
+    const std::vector<DeathEvent> evs(batch, DeathEvent{NPCHandle::make(0, 1), NPCHandle::make(1, 1), 1.0, 2.0});
+
+    for (auto _ : state) em.publish(evs);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch));
+}
+BENCHMARK(BM_PublishBatch)->Arg(16)->Arg(1024);
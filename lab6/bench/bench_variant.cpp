@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "combat_visitor.hpp"
+#include "factory.hpp"
+#include "npc.hpp"
+#include "npc_pool.hpp"
+#include "npc_variant.hpp"
+
+// unique_ptr<NPCBase> (virtual accept + CombatVisitor) against inline
+// std::variant values (std::visit over the pair)
+
+namespace {
+
+std::vector<NPCKind> makeKinds(std::size_t n, unsigned seed = 21) {
+    std::mt19937 rng(seed);
+    std::vector<NPCKind> kinds(n);
+    for (auto &k : kinds) k = static_cast<NPCKind>(rng() % kNPCKindCount);
+    return kinds;
+}
+
+// random (attacker, defender) index pairs; the same for both layouts
+std::vector<std::pair<std::uint32_t, std::uint32_t>> makePairs(std::size_t n, std::size_t count) {
+    std::mt19937 rng(22);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs(count);
+    for (auto &p : pairs) p = {static_cast<std::uint32_t>(rng() % n), static_cast<std::uint32_t>(rng() % n)};
+    return pairs;
+}
+
+constexpr std::size_t kPairs = 1 << 20;
+
+} // namespace
+
+// args are {npc count}
+static void BM_DispatchPointer(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto kinds = makeKinds(n);
+    std::vector<std::unique_ptr<NPCBase>> npcs;
+    for (std::size_t i = 0; i < n; ++i) npcs.push_back(NPCFactory::create(kinds[i], "npc_" + std::to_string(i), 1, 1));
+    const auto pairs = makePairs(n, kPairs);
+
+    std::size_t deaths = 0;
+    for (auto _ : state) {
+        for (auto [a, d] : pairs) {
+            CombatVisitor cv(npcs[a].get());
+            npcs[d]->accept(cv);
+            deaths += cv.victimDies() + cv.attackerDies();
+        }
+    }
+    benchmark::DoNotOptimize(deaths);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kPairs));
+}
+BENCHMARK(BM_DispatchPointer)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_DispatchVariant(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto kinds = makeKinds(n);
+    std::vector<NPCVariant> npcs;
+    npcs.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) npcs.push_back(*makeNPCVariant(kinds[i], "npc_" + std::to_string(i), 1, 1));
+    const auto pairs = makePairs(n, kPairs);
+
+    std::size_t deaths = 0;
+    for (auto _ : state) {
+        for (auto [a, d] : pairs) {
+            const CombatOutcome out = fight(npcs[a], npcs[d]);
+            deaths += out.victimDies + out.attackerDies;
+        }
+    }
+    benchmark::DoNotOptimize(deaths);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kPairs));
+}
+BENCHMARK(BM_DispatchVariant)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// building a roster of n NPCs, state in a slab pool; args are {npc count}
+static void BM_BuildPointer(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto kinds = makeKinds(n);
+    NPCPool *pool = new NPCPool;
+    for (auto _ : state) {
+        std::vector<std::unique_ptr<NPCBase>> npcs;
+        npcs.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) npcs.push_back(NPCFactory::create(kinds[i], "npc", 1, 1, pool));
+        benchmark::DoNotOptimize(npcs.data());
+    }
+    pool->release();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+BENCHMARK(BM_BuildPointer)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_BuildVariant(benchmark::State &state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto kinds = makeKinds(n);
+    NPCPool *pool = new NPCPool;
+    for (auto _ : state) {
+        std::vector<NPCVariant> npcs;
+        npcs.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) npcs.push_back(*makeNPCVariant(kinds[i], "npc", 1, 1, pool));
+        benchmark::DoNotOptimize(npcs.data());
+    }
+    pool->release();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+BENCHMARK(BM_BuildVariant)->Arg(100000)->Unit(benchmark::kMillisecond);
@@ -1,11 +1,8 @@
 #pragma once
-#include <string>
+#include "npc_kind.hpp"
 
 
 class NPCBase;
-class Orc;
-class Bear;
-class Squirrel;
 
 
 class CombatVisitor {
@@ -15,12 +12,15 @@ public:
     bool victimDies() const noexcept;
     bool attackerDies() const noexcept;
 
-    void visit(Orc &def);
-    void visit(Bear &def);
-    void visit(Squirrel &def);
+    // every species' accept() lands here with its own type; the outcome is
+    // a lookup in the kill matrix
+    template <class Species>
+    void visit(Species &) noexcept { resolve(Species::kKind); }
 
 private:
+    void resolve(NPCKind defender) noexcept;
+
     NPCBase* attacker_;
     bool victimDies_ = false;
     bool attackerDies_ = false;
-};
\ No newline at end of file
+};
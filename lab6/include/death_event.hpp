@@ -0,0 +1,15 @@
+#pragma once
+#include <type_traits>
+
+#include "npc_handle.hpp"
+
+
+// Who killed whom and where. Names are not copied into the event; observers
+// resolve the handles through the INameSource they are given.
+struct DeathEvent {
+    NPCHandle killer;
+    NPCHandle victim;
+    double x;
+    double y;
+};
+static_assert(std::is_trivially_copyable_v<DeathEvent>);
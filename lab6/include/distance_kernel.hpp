@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+enum class DistanceKernel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// best kernel this CPU supports; always Scalar when built with LAB6_FORCE_SCALAR
+DistanceKernel activeDistanceKernel() noexcept;
+const char* distanceKernelName(DistanceKernel k) noexcept;
+
+// Sets bit k of mask[k / 64] iff (px - xs[k])^2 + (py - ys[k])^2 <= r2 and
+// clears it otherwise; mask must hold (count + 63) / 64 words. Every kernel
+// evaluates dx*dx + dy*dy exactly like the scalar loop, so results match bit
+// for bit. Asking for a kernel the CPU lacks falls back to the active one.
+void inRangeMask(double px, double py, const double *xs, const double *ys,
+                 std::size_t count, double r2, std::uint64_t *mask) noexcept;
+void inRangeMask(DistanceKernel k, double px, double py, const double *xs, const double *ys,
+                 std::size_t count, double r2, std::uint64_t *mask) noexcept;
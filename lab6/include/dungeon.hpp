@@ -1,11 +1,57 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+
+#include "death_event.hpp"
+#include "npc_handle.hpp"
 
 
 class NPCBase;
 class EventManager;
+class NPCPool;
+class IMovementPolicy;
+struct WorldSpec;
+
+
+// one round of Dungeon::simulate
+struct CombatRound {
+    std::size_t deaths;      // NPCs killed in the round
+    std::size_t survivors;   // NPCs left after it
+    std::size_t moved = 0;   // NPCs whose position changed before it
+};
+
+// What combat rounds did, summed since the last resetStats(). Collected only
+// while enabled; a dungeon with stats off pays a few branches per round.
+struct CombatStats {
+    std::uint64_t rounds = 0;
+    std::uint64_t pairsExamined = 0;   // candidates put through the distance test
+    std::uint64_t pairsInRange = 0;    // distinct live pairs within range whose species can fight
+    std::uint64_t kills = 0;           // kill relations found; a victim may have several
+    std::uint64_t events = 0;          // death events published
+    std::uint64_t removed = 0;         // NPCs erased after their round
+
+    // wall time of each phase, nanoseconds
+    std::uint64_t snapshotNs = 0;      // dirty sweep and spatial grid
+    std::uint64_t scanNs = 0;          // pair scan
+    std::uint64_t applyNs = 0;         // ordering victims and marking them dead
+    std::uint64_t notifyNs = 0;        // building and publishing the events
+    std::uint64_t eraseNs = 0;         // removing the dead
+};
+
+// what runCombat(range) would do to a copy of the dungeon
+struct CombatSweep {
+    double range;
+    std::vector<DeathEvent> events;   // in runCombat's order, one per victim
+};
+
+struct SimulationResult {
+    std::vector<CombatRound> rounds;
+    bool stable = false;     // stopped because nobody could be killed any more
+};
 
 
 class Dungeon {
@@ -14,16 +60,93 @@ public:
     ~Dungeon();
 
     bool addNPC(std::unique_ptr<NPCBase> npc);
+    bool removeNPC(const std::string &name);
+    bool contains(const std::string &name) const noexcept;
+    const NPCBase* find(const std::string &name) const;            // nullptr if absent
+    std::size_t size() const noexcept;
+
+    // Every NPC gets a handle when it is added (at most 2^24 NPCs at a
+    // time). Handles, not names, are what death events carry. A handle
+    // stays valid while its NPC is in the dungeon; a killed or removed NPC
+    // still resolves to its name until compaction drops it, and after that
+    // its handle is stale. Stale handles are told apart by an 8-bit
+    // generation, so a handle kept across 255 reuses of its entry may alias.
+    NPCHandle handleOf(const std::string &name) const noexcept;    // null if absent
+    std::string_view nameOf(NPCHandle h) const noexcept;           // empty if stale
+    const NPCBase* find(NPCHandle h) const;                        // nullptr unless in the dungeon
+
     bool loadFromFile(const std::string &fname);
     bool saveToFile(const std::string &fname) const;
+
+    // Versioned binary snapshot: header, kind/alive/x/y columns and a name
+    // string table. Round-trips coordinates exactly; loading copies the
+    // columns in bulk from a memory mapping, and the NPC object of a loaded
+    // NPC is only made when find() first returns it. loadBinary leaves the
+    // dungeon untouched and returns false if the file is not a valid snapshot.
+    bool saveBinary(const std::string &fname) const;
+    bool loadBinary(const std::string &fname);
     void clear() noexcept;
 
+    // Removed and killed NPCs leave tombstones that are dropped in one pass
+    // once they exceed `fraction` of the storage (0.25 by default; 0 drops
+    // them after every removal or round). compact() drops them now, e.g.
+    // between rounds when there is time to spare.
+    void setCompactionThreshold(double fraction) noexcept;
+    void compact();
+
+    // Adds the NPCs of a synthetic world straight into the dungeon's
+    // storage; generated names already in use are skipped. Returns the
+    // number of NPCs added.
+    std::size_t generate(const WorldSpec &spec);
+
     void printAll() const;
 
     EventManager& events() noexcept;
 
+    // slab pool for this dungeon's NPCs, for NPCFactory::create(..., pool);
+    // NPCs from any pool (or none) can be added to any dungeon
+    NPCPool* pool() noexcept;
+
+    // worker threads used by runCombat; 0 = one per hardware thread, 1 = serial.
+    // The result does not depend on the thread count.
+    void setThreads(unsigned threads);
+    unsigned threads() const noexcept;
+
     void runCombat(double range);
 
+    // One result per range, in the given order, each matching what
+    // runCombat(range) would publish on a copy of this dungeon; the dungeon
+    // itself is left as it is. Candidate pairs are found once, up to the
+    // largest range, so a sweep over many ranges costs about one round at
+    // the largest. Ranges that runCombat would ignore (negative, NaN) give
+    // no events. The events' handles resolve through this dungeon. Sweeps
+    // may run concurrently on one dungeon: one at a time uses the worker
+    // threads, the others run on their caller's thread.
+    std::vector<CombatSweep> sweepCombat(std::span<const double> ranges) const;
+
+    void enableStats(bool on) noexcept;
+    bool statsEnabled() const noexcept;
+    const CombatStats& stats() const noexcept;
+    void resetStats() noexcept;
+
+    // Movement tick: the policy picks a step for every NPC, steps longer
+    // than the kind's moveDistance() are shortened to it, positions are
+    // updated in bulk and clamped to the map. Returns how many NPCs actually
+    // changed position; only those are re-examined by the next round.
+    std::size_t move(IMovementPolicy &policy);
+
+    // maxRounds value for simulate: fight until nobody can be killed; not
+    // allowed with a movement policy, which may keep NPCs apart forever
+    static constexpr std::size_t untilStable = 0;
+
+    // Up to maxRounds combat rounds, each exactly like runCombat(range),
+    // preceded by move(*movement) if a policy is given. Stops early once no
+    // remaining pair can kill: no two species left can fight, or a round
+    // in which nobody moved killed nobody; that round is included. Throws
+    // std::invalid_argument for a policy with maxRounds == untilStable.
+    SimulationResult simulate(double range, std::size_t maxRounds = untilStable,
+                              IMovementPolicy *movement = nullptr);
+
 private:
     struct Impl;
     Impl* pimpl_;
@@ -1,14 +1,36 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <string_view>
+
+
+#include "npc_kind.hpp"
 
 
 class NPCBase;
+class NPCPool;
+
+
+// one roster line split into fields; the views point into the parsed line
+struct NPCRecord {
+    std::string_view type;
+    std::string_view name;
+    double x = 0.0;
+    double y = 0.0;
+};
 
 
 class NPCFactory {
 public:
-    static std::unique_ptr<NPCBase> create(const std::string &type, const std::string &name, double x, double y);
+    // pass Dungeon::pool() to place the NPC in that dungeon's slabs
+    static std::unique_ptr<NPCBase> create(std::string_view type, std::string_view name, double x, double y,
+                                           NPCPool *pool = nullptr);
+    static std::unique_ptr<NPCBase> create(NPCKind kind, std::string_view name, double x, double y,
+                                           NPCPool *pool = nullptr);
+
+    // "<type> <name> <x> <y>", read like `stream >> type >> name >> x >> y`
+    // in the classic locale; anything after y is ignored
+    static bool parseLine(std::string_view line, NPCRecord &out) noexcept;
 
-    static std::unique_ptr<NPCBase> createFromLine(const std::string &line);
+    static std::unique_ptr<NPCBase> createFromLine(std::string_view line, NPCPool *pool = nullptr);
 };
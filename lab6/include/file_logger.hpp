@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "observer.hpp"
+
+
+struct FileLoggerOptions {
+    std::size_t bufferBytes = 1 << 20;            // in-memory buffer; a full buffer is always written out
+    bool flushEachBatch = true;                   // flush after every onDeaths batch (one combat round)
+    std::size_t flushThreshold = 0;               // flush once this many bytes are buffered; 0 = off
+    std::chrono::milliseconds flushInterval{0};   // flush on the first event after this much time; 0 = off
+                                                  // (no timer: an idle logger holds its lines until the
+                                                  // next event, flush() or its destruction)
+    std::uint64_t rotateBytes = 0;                // start a new file past this size; 0 = never rotate
+    unsigned keepFiles = 3;                       // rotated files kept as <path>.1 .. <path>.N
+    bool syncOnFlush = false;                     // fsync after each flush (POSIX only)
+};
+
+
+// Appends one line per death to a file that stays open for the logger's
+// lifetime. Lines are collected in a buffer and written out according to
+// the flush policy.
+//
+// Write errors: what a flush could not write stays buffered and is retried
+// by the next flush, and good() turns false until a flush gets everything
+// out. While the file takes nothing, lines that no longer fit in the
+// buffer are dropped and counted by lostLines().
+//
+// Crash safety: lines still in the buffer are lost if the process dies.
+// A flush hands the data to the OS, so it survives a process crash but not
+// a power loss unless syncOnFlush is set. Lines are never split across
+// files and a rotated file always ends at a line boundary.
+class FileLogger : public IObserver {
+public:
+    explicit FileLogger(std::string path = "log.txt", FileLoggerOptions opts = {});
+    ~FileLogger() override;
+
+    FileLogger(const FileLogger&) = delete;
+    FileLogger& operator=(const FileLogger&) = delete;
+
+    void onDeath(const DeathEvent &ev, const INameSource &names) override;
+    void onDeaths(std::span<const DeathEvent> evs, const INameSource &names) override;
+
+    void flush();
+    // false if the file could not be opened or the last flush could not
+    // write everything
+    bool good() const noexcept { return file_ != nullptr && !failed_; }
+    std::uint64_t lostLines() const noexcept { return lostLines_; }
+
+private:
+    void append(const DeathEvent &ev, const INameSource &names);
+    void maybeFlush();
+    void flushLocked();
+    void rotateLocked();
+    bool openLocked();
+
+    std::string path_;
+    FileLoggerOptions opts_;
+    std::mutex m_;
+    std::FILE *file_ = nullptr;
+    std::uint64_t fileBytes_ = 0;
+    std::vector<char> buf_;
+    bool failed_ = false;         // the last flush left data behind
+    bool midLine_ = false;        // buf_ starts in the middle of a line
+    std::uint64_t lostLines_ = 0;
+    std::chrono::steady_clock::time_point lastFlush_;
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+// Read-only view of a whole file. On POSIX systems the file is memory-mapped,
+// elsewhere it is read into memory once.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string &fname);
+    void close() noexcept;
+
+    std::string_view data() const noexcept { return {data_, size_}; }
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;   // fallback storage when mapping is not possible
+};
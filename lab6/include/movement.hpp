@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <span>
+#include "species.hpp"
+
+
+// how far one NPC of each kind may move in one tick
+inline constexpr std::array<double, kNPCKindCount> kMoveDistance =
+    perSpecies(SpeciesRegistry{}, [](auto s) { return decltype(s)::type::kMoveDistance; });
+
+constexpr double moveDistance(NPCKind kind) noexcept {
+    const auto k = static_cast<std::size_t>(kind);
+    return k < kNPCKindCount ? kMoveDistance[k] : 0.0;
+}
+
+
+// the NPCs of one dungeon as a policy sees them; slot i of every span is
+// the same NPC
+struct MoveContext {
+    std::span<const double> x;
+    std::span<const double> y;
+    std::span<const NPCKind> kind;
+};
+
+
+// Decides where NPCs go in a movement tick. The dungeon shortens steps
+// longer than moveDistance() of the NPC's kind, adds them to the positions
+// and clamps the result to the map, so a policy never has to check bounds
+// or speeds itself.
+class IMovementPolicy {
+public:
+    virtual ~IMovementPolicy() = default;
+    // dx and dy have one entry per NPC in ctx and arrive zeroed
+    virtual void steps(const MoveContext &ctx, std::span<double> dx, std::span<double> dy) = 0;
+};
+
+
+// every NPC takes a full step of its kind's move distance in a random
+// direction; the same seed gives the same walk
+class RandomWalk : public IMovementPolicy {
+public:
+    explicit RandomWalk(std::uint64_t seed = 1) : rng_(seed) {}
+    void steps(const MoveContext &ctx, std::span<double> dx, std::span<double> dy) override;
+
+private:
+    std::mt19937_64 rng_;
+};
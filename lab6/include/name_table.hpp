@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Interned NPC names with a hash index, so uniqueness checks and lookups by
+// name are O(1). Ids are small integers that stay valid until released;
+// views stay valid for as long as their id does. An unindexed name can no
+// longer be found and may be added again, but keeps its id and text until
+// it is released.
+class NameTable {
+public:
+    static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+    // the name must not be in the table yet
+    std::uint32_t add(std::string_view name);
+    void unindex(std::uint32_t id);
+    void release(std::uint32_t id);   // unindexes first if needed
+    std::uint32_t find(std::string_view name) const noexcept;
+    bool contains(std::string_view name) const noexcept { return find(name) != npos; }
+    std::string_view view(std::uint32_t id) const noexcept {
+        if (id >= bulkEnd_.size()) return names_[id - bulkEnd_.size()];
+        const std::uint64_t begin = id ? bulkEnd_[id - 1] : 0;
+        return {bulkText_.get() + begin, static_cast<std::size_t>(bulkEnd_[id] - begin)};
+    }
+    std::size_t size() const noexcept { return size_; }   // indexed names
+    void reserve(std::size_t n);
+    void clear() noexcept;
+
+    // Replaces the contents with names stored back to back in `text`, name
+    // i ending at ends[i] (ascending, at most text.size()) and getting id i.
+    // The names with take[i] set are indexed; one that repeats a name
+    // indexed before it is not, and its take[i] is cleared. The text is
+    // copied in one piece and the index filled in order of home slot, not
+    // one name at a time.
+    void assign(std::string_view text, std::span<const std::uint64_t> ends, std::span<std::uint8_t> take);
+
+private:
+    // open-addressing index with linear probing: one flat allocation
+    // instead of a node per name
+    struct Slot {
+        std::uint32_t id = npos;   // npos = empty, kTombstone = erased
+        std::uint32_t tag = 0;     // low bits of the hash, checked before the string
+    };
+    static constexpr std::uint32_t kTombstone = npos - 1;
+
+    std::size_t probe(std::string_view name, std::size_t hash) const noexcept;
+    void rehash(std::size_t capacity);
+
+    // names from assign(), id i ending at bulkEnd_[i]; their ids are not reused
+    std::unique_ptr<char[]> bulkText_;
+    std::vector<std::uint64_t> bulkEnd_;
+    std::deque<std::string> names_;      // id bulkEnd_.size() + k; deque keeps strings in place as it grows
+    std::vector<std::uint32_t> free_;
+    std::vector<Slot> slots_;            // size is zero or a power of two
+    std::size_t size_ = 0;
+    std::size_t used_ = 0;               // live + tombstone slots
+};
@@ -1,25 +1,52 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include "npc_kind.hpp"
 
 class CombatVisitor;
+class Dungeon;
+struct NPCColumns;
+class NPCPool;
 
 class NPCBase {
 public:
-    NPCBase(std::string name, double x, double y) noexcept;
+    // with a pool, the object's state is placed in the pool too
+    NPCBase(std::string name, double x, double y, NPCPool *pool = nullptr) noexcept;
     virtual ~NPCBase();
 
-    std::string name() const noexcept;
+    // NPCs are moved, never copied; a moved-from NPC can only be destroyed
+    // or assigned to. Moving an NPC that a Dungeon holds is not allowed.
+    NPCBase(NPCBase &&other) noexcept;
+    NPCBase& operator=(NPCBase &&other) noexcept;
+    NPCBase(const NPCBase&) = delete;
+    NPCBase& operator=(const NPCBase&) = delete;
+
+    // NPCs always come from NPCPool blocks: `new T(...)` uses the heap,
+    // `new (pool) T(...)` the given pool; delete returns either to its owner
+    static void* operator new(std::size_t size);
+    static void* operator new(std::size_t size, NPCPool *pool);
+    static void operator delete(void *p) noexcept;
+    static void operator delete(void *p, NPCPool *pool) noexcept;
+
+    std::string_view name() const noexcept;
     double x() const noexcept;
     double y() const noexcept;
     bool alive() const noexcept;
 
     void markDead() noexcept;
 
-    virtual std::string type() const noexcept = 0;
+    virtual std::string_view type() const noexcept = 0;   // static storage
+    virtual NPCKind kind() const noexcept = 0;
 
     virtual void accept(CombatVisitor &v) = 0;
 
 private:
+    friend class Dungeon;
+    // once bound, x/y/alive are read from and written to slot `slot` of `cols`
+    void bind(NPCColumns *cols, std::uint32_t slot) noexcept;
+
     struct Impl;
     Impl* pimpl;
 };
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "npc_handle.hpp"
+#include "npc_kind.hpp"
+
+
+// Structure-of-arrays storage for the NPCs of one Dungeon. Slot i of every
+// column describes the same NPC; NPCBase objects bound to a slot read
+// their position and liveness from here.
+struct NPCColumns {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<NPCKind> kind;
+    std::vector<std::uint8_t> alive;      // 1 = alive, 0 = dead
+    std::vector<std::uint32_t> nameId;    // id in the Dungeon's NameTable
+    std::vector<std::uint8_t> dirty;      // 1 = added or moved since the last combat round
+    std::vector<std::uint8_t> tomb;       // 1 = removed, the slot waits for compaction
+    std::vector<NPCHandle> handle;        // stable handle of the NPC in the slot
+
+    std::size_t size() const noexcept { return x.size(); }
+
+    std::uint32_t push(double xx, double yy, NPCKind k, std::uint32_t name, NPCHandle h) {
+        x.push_back(xx);
+        y.push_back(yy);
+        kind.push_back(k);
+        alive.push_back(1);
+        nameId.push_back(name);
+        dirty.push_back(1);
+        tomb.push_back(0);
+        handle.push_back(h);
+        return static_cast<std::uint32_t>(x.size() - 1);
+    }
+
+    // copies slot `from` into slot `to` (to <= from), used while compacting
+    void moveSlot(std::size_t from, std::size_t to) noexcept {
+        x[to] = x[from];
+        y[to] = y[from];
+        kind[to] = kind[from];
+        alive[to] = alive[from];
+        nameId[to] = nameId[from];
+        dirty[to] = dirty[from];
+        tomb[to] = tomb[from];
+        handle[to] = handle[from];
+    }
+
+    void resize(std::size_t n) {
+        x.resize(n);
+        y.resize(n);
+        kind.resize(n);
+        alive.resize(n);
+        nameId.resize(n);
+        dirty.resize(n);
+        tomb.resize(n);
+        handle.resize(n);
+    }
+
+    void reserve(std::size_t n) {
+        x.reserve(n);
+        y.reserve(n);
+        kind.reserve(n);
+        alive.reserve(n);
+        nameId.reserve(n);
+        dirty.reserve(n);
+        tomb.reserve(n);
+        handle.reserve(n);
+    }
+
+    void clear() noexcept { resize(0); }
+};
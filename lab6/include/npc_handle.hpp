@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+
+// Stable reference to one NPC of one Dungeon: an index into the dungeon's
+// handle table (upper 24 bits) and the generation of that entry (lower 8
+// bits). A handle keeps naming its NPC while slots are compacted; once the
+// NPC is gone and the entry reused, the generation no longer matches and
+// the handle is stale. Generations run 1..255, so the value 0 is never a
+// real NPC.
+struct NPCHandle {
+    static constexpr unsigned kGenerationBits = 8;
+    static constexpr std::uint32_t kGenerationMask = (1u << kGenerationBits) - 1;
+    static constexpr std::uint32_t kMaxIndex = (1u << (32 - kGenerationBits)) - 1;
+
+    std::uint32_t value = 0;
+
+    static constexpr NPCHandle make(std::uint32_t index, std::uint8_t generation) noexcept {
+        return {(index << kGenerationBits) | generation};
+    }
+
+    constexpr std::uint32_t index() const noexcept { return value >> kGenerationBits; }
+    constexpr std::uint8_t generation() const noexcept {
+        return static_cast<std::uint8_t>(value & kGenerationMask);
+    }
+    constexpr explicit operator bool() const noexcept { return value != 0; }
+
+    friend constexpr bool operator==(NPCHandle, NPCHandle) noexcept = default;
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+// Species ids. Names, kill rules and everything else about a species come
+// from its class and the registry in species.hpp; Unknown stays last.
+enum class NPCKind : std::uint8_t {
+    Orc,
+    Bear,
+    Squirrel,
+    Unknown
+};
+
+inline constexpr std::size_t kNPCKindCount = static_cast<std::size_t>(NPCKind::Unknown);   // real kinds
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Slab allocator for NPC objects and their pimpl state. Blocks are carved
+// from large slabs in a few size classes and freed blocks go onto a per-class
+// free list for reuse, so creating and destroying NPCs does not hit malloc.
+//
+// Every block starts with a small header naming its pool, which lets
+// deallocate() route a block back without knowing where it came from
+// (blocks allocated with pool == nullptr live on the global heap).
+// The owner calls release() instead of deleting the pool; the slabs are freed
+// once the last outstanding block comes back. Not thread-safe: a pool is
+// used by one Dungeon and the code that feeds it.
+class NPCPool {
+public:
+    NPCPool() = default;
+    NPCPool(const NPCPool&) = delete;
+    NPCPool& operator=(const NPCPool&) = delete;
+
+    static void* allocate(std::size_t size, NPCPool *pool);
+    static void deallocate(void *p) noexcept;
+
+    void release() noexcept;
+
+    std::size_t liveBlocks() const noexcept { return live_; }
+    std::size_t slabCount() const noexcept { return slabs_.size(); }
+
+private:
+    ~NPCPool();
+
+    struct alignas(16) Header {
+        NPCPool *owner;
+        std::uint32_t sizeClass;
+    };
+    struct FreeBlock { FreeBlock *next; };
+
+    static constexpr std::size_t kGranule = 16;
+    static constexpr std::size_t kClassCount = 16;           // blocks up to 256 bytes
+    static constexpr std::size_t kSlabBytes = 256 * 1024;
+
+    void* take(std::size_t sizeClass);
+    void give(Header *h) noexcept;
+
+    std::vector<char*> slabs_;
+    FreeBlock *free_[kClassCount] = {};
+    char *bump_ = nullptr;
+    char *bumpEnd_ = nullptr;
+    std::size_t live_ = 0;
+    bool released_ = false;
+};
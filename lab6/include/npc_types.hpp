@@ -1,26 +1,63 @@
 #pragma once
+#include <cstdint>
+#include <string_view>
+#include "combat_visitor.hpp"
 #include "npc.hpp"
 
 
-class Orc final : public NPCBase {
+// set of kinds, for the kPrey trait
+template <class... Kinds>
+constexpr std::uint32_t kindSet(Kinds... kinds) noexcept {
+    return (0u | ... | (1u << static_cast<unsigned>(kinds)));
+}
+
+
+// What every species class shares. The overrides are generated from the
+// traits the species declares:
+//   kKind          its NPCKind
+//   kName          type name in rosters and commands
+//   kPrey          kindSet() of the kinds it kills
+//   kMoveDistance  how far it may move in one tick
+// A new species is a class like the ones below, an NPCKind value and an
+// entry in SpeciesRegistry (species.hpp).
+template <class Derived>
+class NPCSpecies : public NPCBase {
 public:
     using NPCBase::NPCBase;
-    std::string type() const noexcept override;
-    void accept(CombatVisitor &v) override;
+    std::string_view type() const noexcept final { return Derived::kName; }
+    NPCKind kind() const noexcept final { return Derived::kKind; }
+    void accept(CombatVisitor &v) final { v.visit(static_cast<Derived&>(*this)); }
 };
 
 
-class Bear final : public NPCBase {
+class Orc final : public NPCSpecies<Orc> {
 public:
-    using NPCBase::NPCBase;
-    std::string type() const noexcept override;
-    void accept(CombatVisitor &v) override;
+    static constexpr NPCKind kKind = NPCKind::Orc;
+    static constexpr std::string_view kName = "Orc";
+    static constexpr std::uint32_t kPrey = kindSet(NPCKind::Orc, NPCKind::Bear);
+    static constexpr double kMoveDistance = 20.0;
+
+    using NPCSpecies::NPCSpecies;
 };
 
 
-class Squirrel final : public NPCBase {
+class Bear final : public NPCSpecies<Bear> {
 public:
-    using NPCBase::NPCBase;
-    std::string type() const noexcept override;
-    void accept(CombatVisitor &v) override;
+    static constexpr NPCKind kKind = NPCKind::Bear;
+    static constexpr std::string_view kName = "Bear";
+    static constexpr std::uint32_t kPrey = kindSet(NPCKind::Squirrel);
+    static constexpr double kMoveDistance = 5.0;
+
+    using NPCSpecies::NPCSpecies;
+};
+
+
+class Squirrel final : public NPCSpecies<Squirrel> {
+public:
+    static constexpr NPCKind kKind = NPCKind::Squirrel;
+    static constexpr std::string_view kName = "Squirrel";
+    static constexpr std::uint32_t kPrey = kindSet();
+    static constexpr double kMoveDistance = 5.0;
+
+    using NPCSpecies::NPCSpecies;
 };
@@ -0,0 +1,48 @@
+#pragma once
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include "species.hpp"
+
+
+class NPCPool;
+
+
+// Value storage for NPCs: std::variant<Orc, Bear, Squirrel>, generated from
+// the registry. A std::vector<NPCVariant> keeps the objects inline, with
+// no vtable hop to learn what an NPC is; only the NPC's state is a separate
+// block (in the given pool, if any).
+template <class... Species>
+std::variant<Species...> variantOf(SpeciesList<Species...>);
+
+using NPCVariant = decltype(variantOf(SpeciesRegistry{}));
+
+// nullopt for NPCKind::Unknown
+std::optional<NPCVariant> makeNPCVariant(NPCKind kind, std::string_view name, double x, double y,
+                                         NPCPool *pool = nullptr);
+
+inline const NPCBase& baseOf(const NPCVariant &npc) noexcept {
+    return std::visit([](const NPCBase &n) -> const NPCBase& { return n; }, npc);
+}
+
+// the registry is in NPCKind order, so the alternative index is the kind
+inline NPCKind kindOf(const NPCVariant &npc) noexcept {
+    return static_cast<NPCKind>(npc.index());
+}
+
+struct CombatOutcome {
+    bool victimDies = false;
+    bool attackerDies = false;
+};
+
+// Same answer as CombatVisitor, dispatched by std::visit over the pair: both
+// species are template parameters here, so every case is a constant and
+// the visit compiles to a jump table.
+inline CombatOutcome fight(const NPCVariant &attacker, const NPCVariant &defender) noexcept {
+    return std::visit([](const auto &a, const auto &d) noexcept {
+        constexpr NPCKind ka = std::decay_t<decltype(a)>::kKind;
+        constexpr NPCKind kd = std::decay_t<decltype(d)>::kKind;
+        return CombatOutcome{kills(ka, kd), kills(kd, ka)};
+    }, attacker, defender);
+}
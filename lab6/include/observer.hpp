@@ -1,28 +1,87 @@
 #pragma once
-#include <string>
-#include <vector>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
 
+#include "death_event.hpp"
 
-struct DeathEvent { 
-    std::string killer; 
-    std::string victim; 
-    double x; 
-    double y; 
+
+// Resolves NPC handles to names.
+class INameSource {
+public:
+    virtual ~INameSource() = default;
+    // empty for a null or stale handle
+    virtual std::string_view nameOf(NPCHandle h) const noexcept = 0;
 };
 
 
 class IObserver {
 public:
     virtual ~IObserver() = default;
-    virtual void onDeath(const DeathEvent &ev) = 0;
+    // `names` resolves the event's handles; views it returns are valid
+    // until the call returns
+    virtual void onDeath(const DeathEvent &ev, const INameSource &names) = 0;
+    // one call per published batch (a combat round); the default forwards
+    // every event to onDeath
+    virtual void onDeaths(std::span<const DeathEvent> evs, const INameSource &names) {
+        for (auto &ev : evs) onDeath(ev, names);
+    }
 };
 
 
 class EventManager {
 public:
-    void subscribe(std::shared_ptr<IObserver> observers_);
+    EventManager();
+    ~EventManager();
+
+    EventManager(const EventManager&) = delete;
+    EventManager& operator=(const EventManager&) = delete;
+
+    // safe from any thread, also from inside an observer's callback; the
+    // new observer receives events from the next notify or publish on
+    void subscribe(std::shared_ptr<IObserver> obs);
+
+    // Source observers resolve handles with (a Dungeon sets its own); with
+    // none set every name is empty. The source must outlive the manager.
+    void setNameSource(const INameSource *names) noexcept;
+
     void notify(const DeathEvent &ev) const;
+
+    // Delivers a batch through onDeaths. In async mode the batch and the
+    // names it refers to are copied, queued and handed to observers later on
+    // a dispatcher thread, in publish order; the dispatcher never touches
+    // the name source. A synchronous publish does not allocate.
+    void publish(std::span<const DeathEvent> batch);
+
+    // switching modes flushes everything queued so far
+    void setAsync(bool on);
+    bool async() const noexcept { return async_ != nullptr; }
+
+    // blocks until every batch published before the call has been delivered
+    void flush();
+
 private:
-    std::vector<std::shared_ptr<IObserver>> observers_;
+    struct AsyncQueue;
+    struct FrozenNames;
+
+    const INameSource& names() const noexcept;
+    void deliver(std::span<const DeathEvent> evs, const INameSource &names);
+
+    using ObserverList = std::vector<std::shared_ptr<IObserver>>;
+
+    // snapshot of the current observers; calling them needs no lock
+    std::shared_ptr<const ObserverList> observers() const;
+
+    // copy-on-write: subscribe swaps in a new list, so a snapshot taken
+    // for a delivery stays valid and unchanged, and taking one does not
+    // allocate
+    std::shared_ptr<const ObserverList> observers_;
+    mutable std::mutex observersMutex_;   // guards the observers_ pointer only
+    const INameSource *names_ = nullptr;
+    std::unique_ptr<AsyncQueue> async_;
 };
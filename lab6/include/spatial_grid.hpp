@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+
+// Uniform grid over the square [0, worldSize]^2. Cells are at least `range`
+// wide, so every point within `range` of a query lies in the 3x3 block
+// of cells around it. A grid can be rebuilt in place for the next round,
+// or updated after some of its points moved. It indexes either every
+// point of xs/ys or a subset of them; indices are those of xs/ys either way.
+class SpatialGrid {
+public:
+    void build(const std::vector<double> &xs, const std::vector<double> &ys,
+               double range, double worldSize);
+    // indexes only `points` (ascending indices into xs/ys)
+    void build(const std::vector<double> &xs, const std::vector<double> &ys,
+               std::span<const std::uint32_t> points, double range, double worldSize);
+
+    // Moves the points listed in `moved` to their new coordinates (xs/ys are
+    // the arrays the grid was built from, same size; moved points the grid
+    // does not index are ignored). Points that stay in
+    // their cell are patched in place; crossers are shifted from cell to
+    // cell, one entry per cell boundary passed. If that adds up to more work
+    // than a rebuild, the grid is rebuilt instead and false is returned.
+    bool update(const std::vector<double> &xs, const std::vector<double> &ys,
+                const std::vector<std::uint32_t> &moved);
+
+    double range() const noexcept { return range_; }
+    std::size_t size() const noexcept { return items_.size(); }   // indexed points
+
+    std::size_t dims() const noexcept { return dims_; }
+    std::size_t cellX(double x) const noexcept;
+    std::size_t cellY(double y) const noexcept;
+
+    // point indices and their coordinates, all in cell order
+    const std::uint32_t* items() const noexcept { return items_.data(); }
+    const double* xs() const noexcept { return xs_.data(); }
+    const double* ys() const noexcept { return ys_.data(); }
+
+    // calls f(b, e) for each run [b, e) of cell-ordered positions covering
+    // the 3x3 cells around (x, y); neighbouring cells of one row are
+    // contiguous, so there are at most three runs
+    template <class F>
+    void forEachNearRun(double x, double y, F &&f) const {
+        const std::size_t cx = cellX(x), cy = cellY(y);
+        const std::size_t x0 = cx > 0 ? cx - 1 : 0;
+        const std::size_t x1 = cx + 1 < dims_ ? cx + 1 : cx;
+        const std::size_t y0 = cy > 0 ? cy - 1 : 0;
+        const std::size_t y1 = cy + 1 < dims_ ? cy + 1 : cy;
+        for (std::size_t row = y0; row <= y1; ++row) {
+            const std::uint32_t b = cellStart_[row * dims_ + x0];
+            const std::uint32_t e = cellStart_[row * dims_ + x1 + 1];
+            if (b < e) f(b, e);
+        }
+    }
+
+    // calls f(idx) for every indexed point in the 3x3 cells around (x, y);
+    // indices are ascending within each cell after build(), in no
+    // particular order after update()
+    template <class F>
+    void forEachNear(double x, double y, F &&f) const {
+        forEachNearRun(x, y, [&](std::uint32_t b, std::uint32_t e) {
+            for (std::uint32_t k = b; k < e; ++k) f(items_[k]);
+        });
+    }
+
+private:
+    static constexpr std::uint32_t kNoCell = std::numeric_limits<std::uint32_t>::max();
+
+    void buildPoints(const std::vector<double> &xs, const std::vector<double> &ys);
+    std::uint32_t cellOfPoint(double x, double y) const noexcept {
+        return static_cast<std::uint32_t>(cellY(y) * dims_ + cellX(x));
+    }
+    void relocate(std::uint32_t idx, std::uint32_t to) noexcept;
+    void moveEntry(std::uint32_t from, std::uint32_t to) noexcept;
+
+    double range_ = 0.0, worldSize_ = 0.0;
+    double cellSize_ = 1.0;
+    std::size_t dims_ = 0;
+    std::vector<std::uint32_t> cellStart_;  // CSR offsets, dims_*dims_ + 1
+    std::vector<std::uint32_t> items_;      // point indices grouped by cell
+    std::vector<double> xs_, ys_;           // coordinates of items_, same order
+    std::vector<std::uint32_t> points_;     // indexed points, ascending
+    std::vector<std::uint32_t> cellOf_;     // point index -> cell, kNoCell if not indexed
+    std::vector<std::uint32_t> posOf_;      // point index -> position in items_
+    std::vector<std::uint32_t> fill_;       // build() scratch
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "npc_kind.hpp"
+#include "npc_types.hpp"
+
+
+template <class... Species>
+struct SpeciesList {
+    static constexpr std::size_t size = sizeof...(Species);
+};
+
+// Every species, in NPCKind order. Names and lookup by name, the kill
+// matrix, movement speeds, the factory and the visitor dispatch are all
+// generated from this list and the traits of its classes.
+using SpeciesRegistry = SpeciesList<Orc, Bear, Squirrel>;
+
+// {f(std::type_identity<S>{})...} over a species list, in list order
+template <class... Species, class F>
+constexpr auto perSpecies(SpeciesList<Species...>, F f) {
+    return std::array{f(std::type_identity<Species>{})...};
+}
+
+namespace species_detail {
+
+template <class... Species>
+constexpr bool inKindOrder(SpeciesList<Species...>) noexcept {
+    std::size_t i = 0;
+    return ((static_cast<std::size_t>(Species::kKind) == i++) && ...);
+}
+
+constexpr char lower(char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool equalIgnoreCase(std::string_view a, std::string_view b) noexcept {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (lower(a[i]) != lower(b[i])) return false;
+    return true;
+}
+
+// seeded FNV-1a over the lower-cased name
+constexpr std::uint32_t nameHash(std::string_view s, std::uint32_t seed) noexcept {
+    std::uint32_t h = 2166136261u ^ seed;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(lower(c));
+        h *= 16777619u;
+    }
+    return h;
+}
+
+} // namespace species_detail
+
+static_assert(SpeciesRegistry::size == kNPCKindCount, "every NPCKind needs a registered species");
+static_assert(species_detail::inKindOrder(SpeciesRegistry{}), "SpeciesRegistry must follow NPCKind order");
+
+inline constexpr std::array<std::string_view, kNPCKindCount> kKindNames =
+    perSpecies(SpeciesRegistry{}, [](auto s) { return decltype(s)::type::kName; });
+
+// kKillMatrix[attacker][victim], from the species' kPrey sets
+inline constexpr auto kKillMatrix = [] {
+    constexpr auto prey = perSpecies(SpeciesRegistry{}, [](auto s) { return decltype(s)::type::kPrey; });
+    std::array<std::array<bool, kNPCKindCount>, kNPCKindCount> m{};
+    for (std::size_t a = 0; a < kNPCKindCount; ++a)
+        for (std::size_t v = 0; v < kNPCKindCount; ++v) m[a][v] = (prey[a] >> v) & 1u;
+    return m;
+}();
+
+constexpr bool kills(NPCKind attacker, NPCKind victim) noexcept {
+    const auto a = static_cast<std::size_t>(attacker);
+    const auto v = static_cast<std::size_t>(victim);
+    return a < kNPCKindCount && v < kNPCKindCount && kKillMatrix[a][v];
+}
+
+// true if a meeting of the two kinds can end in a death
+constexpr bool canFight(NPCKind a, NPCKind b) noexcept {
+    return kills(a, b) || kills(b, a);
+}
+
+constexpr std::string_view kindName(NPCKind kind) noexcept {
+    const auto k = static_cast<std::size_t>(kind);
+    return k < kNPCKindCount ? kKindNames[k] : "Unknown";
+}
+
+// Perfect hash of the type names: a seed under which the names, lower-cased,
+// land in distinct slots, found at compile time. A lookup is one hash, one
+// table read and one string compare.
+struct SpeciesNameHash {
+    static constexpr std::size_t kSlots = std::bit_ceil(kNPCKindCount * 2);
+    static constexpr std::uint8_t kEmpty = 0xff;
+
+    std::uint32_t seed = 0;
+    std::array<std::uint8_t, kSlots> kind{};   // slot -> NPCKind, kEmpty if none
+    bool found = false;
+
+    static constexpr std::size_t slotOf(std::string_view name, std::uint32_t seed) noexcept {
+        return species_detail::nameHash(name, seed) & (kSlots - 1);
+    }
+};
+
+inline constexpr SpeciesNameHash kSpeciesNameHash = [] {
+    for (std::uint32_t seed = 0; seed < 4096; ++seed) {
+        SpeciesNameHash h;
+        h.seed = seed;
+        h.kind.fill(SpeciesNameHash::kEmpty);
+        h.found = true;
+        for (std::size_t k = 0; k < kNPCKindCount && h.found; ++k) {
+            std::uint8_t &slot = h.kind[SpeciesNameHash::slotOf(kKindNames[k], seed)];
+            h.found = slot == SpeciesNameHash::kEmpty;
+            slot = static_cast<std::uint8_t>(k);
+        }
+        if (h.found) return h;
+    }
+    return SpeciesNameHash{};
+}();
+static_assert(kSpeciesNameHash.found, "species names must differ, ignoring case");
+
+constexpr NPCKind kindFromName(std::string_view type) noexcept {
+    const std::uint8_t k = kSpeciesNameHash.kind[SpeciesNameHash::slotOf(type, kSpeciesNameHash.seed)];
+    return k != SpeciesNameHash::kEmpty && kKindNames[k] == type ? static_cast<NPCKind>(k) : NPCKind::Unknown;
+}
+
+// "orc", "ORC" and "Orc" all give NPCKind::Orc
+constexpr NPCKind kindFromNameIgnoreCase(std::string_view type) noexcept {
+    const std::uint8_t k = kSpeciesNameHash.kind[SpeciesNameHash::slotOf(type, kSpeciesNameHash.seed)];
+    return k != SpeciesNameHash::kEmpty && species_detail::equalIgnoreCase(kKindNames[k], type)
+               ? static_cast<NPCKind>(k) : NPCKind::Unknown;
+}
+
+static_assert(kindFromName("Bear") == NPCKind::Bear && kindFromName("bear") == NPCKind::Unknown);
+static_assert(kindFromNameIgnoreCase("sQuIrReL") == NPCKind::Squirrel && kindFromName("Elf") == NPCKind::Unknown);
+static_assert(kills(NPCKind::Orc, NPCKind::Bear) && kills(NPCKind::Orc, NPCKind::Orc));
+static_assert(kills(NPCKind::Bear, NPCKind::Squirrel) && !kills(NPCKind::Squirrel, NPCKind::Orc));
+static_assert(!canFight(NPCKind::Squirrel, NPCKind::Squirrel) && !canFight(NPCKind::Bear, NPCKind::Bear));
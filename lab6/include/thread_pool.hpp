@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads for data-parallel loops. The calling thread
+// takes part in every loop, so a pool of size 1 has no workers at all.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const noexcept { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // runs body(begin, end, worker) over [0, count) in chunks of `grain`;
+    // worker is in [0, size()) and no two concurrent calls share it
+    using Body = std::function<void(std::size_t begin, std::size_t end, unsigned worker)>;
+    void parallelFor(std::size_t count, std::size_t grain, const Body &body);
+
+private:
+    void workerLoop(unsigned worker);
+    void runChunks(unsigned worker);
+
+    std::vector<std::thread> workers_;
+    std::mutex m_;
+    std::condition_variable wake_, done_;
+    const Body *body_ = nullptr;
+    std::size_t count_ = 0, grain_ = 1, next_ = 0;
+    unsigned busy_ = 0;
+    unsigned long long generation_ = 0;
+    bool stop_ = false;
+};
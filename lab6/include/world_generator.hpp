@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "npc_kind.hpp"
+
+
+enum class WorldDistribution {
+    Uniform,    // anywhere on the map
+    Clusters    // Gaussian blobs around random centres
+};
+
+// one share per kind: every species equally common
+inline constexpr std::array<double, kNPCKindCount> kEvenRatio = [] {
+    std::array<double, kNPCKindCount> r{};
+    r.fill(1.0);
+    return r;
+}();
+
+// Everything that defines a synthetic world. The same spec gives the same
+// NPCs in the same order for a given toolchain and libm; clustered worlds
+// go through std::log/sin/cos, whose last bits may differ between
+// platforms.
+struct WorldSpec {
+    std::size_t count = 0;
+    std::uint64_t seed = 1;
+    WorldDistribution distribution = WorldDistribution::Uniform;
+    std::size_t clusters = 16;           // Clusters: number of centres
+    double spread = 10.0;                // Clusters: standard deviation around a centre
+    std::array<double, kNPCKindCount> ratio = kEvenRatio;     // relative share of each kind
+    std::string namePrefix = "g";        // NPC k is named "<prefix>_<k>"
+};
+
+// one NPC of a generated world
+struct GeneratedNPC {
+    std::size_t index;
+    NPCKind kind;
+    double x;
+    double y;
+};
+
+// Draws the NPCs of a WorldSpec one by one. Uses its own uniform and
+// normal sampling on top of std::mt19937_64, whose output the standard
+// fixes, so worlds do not depend on the standard library.
+class WorldGenerator {
+public:
+    explicit WorldGenerator(const WorldSpec &spec);
+
+    // false once spec.count NPCs have been produced
+    bool next(GeneratedNPC &out);
+
+private:
+    double uniform();                       // [0, 1)
+    double normal();                        // mean 0, deviation 1
+    NPCKind pickKind();
+
+    WorldSpec spec_;
+    std::mt19937_64 rng_;
+    std::size_t produced_ = 0;
+    std::array<double, kNPCKindCount> cumulative_{};
+    std::vector<std::array<double, 2>> centres_;
+    double spareNormal_ = 0.0;
+    bool haveSpare_ = false;
+};
+
+// parses "uniform" / "clusters"; false for anything else
+bool parseWorldDistribution(std::string_view s, WorldDistribution &out) noexcept;
+
+// name of NPC `index` of a generated world
+std::string generatedName(const WorldSpec &spec, std::size_t index);
+
+// Streams the world to a roster file that loadFromFile reads back with
+// bit-exact coordinates; never holds the whole world in memory.
+bool writeRoster(const WorldSpec &spec, const std::string &fname);
@@ -1,14 +1,6 @@
 #include "combat_visitor.hpp"
 #include "npc.hpp"
-#include "npc_types.hpp"
-#include <string>
-
-static bool wantsKill(const std::string &A, const std::string &B) noexcept {
-    if (A == "Orc") return (B == "Bear" || B == "Orc");
-    if (A == "Bear") return (B == "Squirrel");
-    if (A == "Squirrel") return false;
-    return false;
-}
+#include "species.hpp"
 
 CombatVisitor::CombatVisitor(NPCBase* attacker) noexcept 
     : attacker_(attacker), victimDies_(false), attackerDies_(false) {}
@@ -16,23 +8,8 @@ CombatVisitor::CombatVisitor(NPCBase* attacker) noexcept
 bool CombatVisitor::victimDies() const noexcept { return victimDies_; }
 bool CombatVisitor::attackerDies() const noexcept { return attackerDies_; }
 
-void CombatVisitor::visit(Orc &def) {
-    const std::string A = attacker_->type();
-    const std::string B = def.type();
-    victimDies_   = wantsKill(A, B);
-    attackerDies_ = wantsKill(B, A);
-}
-
-void CombatVisitor::visit(Bear &def) {
-    const std::string A = attacker_->type();
-    const std::string B = def.type();
-    victimDies_   = wantsKill(A, B);
-    attackerDies_ = wantsKill(B, A);
-}
-
-void CombatVisitor::visit(Squirrel &def) {
-    const std::string A = attacker_->type();
-    const std::string B = def.type();
-    victimDies_   = wantsKill(A, B);
-    attackerDies_ = wantsKill(B, A);
+void CombatVisitor::resolve(NPCKind defender) noexcept {
+    const NPCKind a = attacker_->kind();
+    victimDies_   = kills(a, defender);
+    attackerDies_ = kills(defender, a);
 }
@@ -0,0 +1,109 @@
+#include "distance_kernel.hpp"
+
+#if !defined(LAB6_FORCE_SCALAR) && (defined(__x86_64__) || defined(_M_X64))
+#define LAB6_HAVE_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define LAB6_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+static void maskScalar(double px, double py, const double *xs, const double *ys,
+                       std::size_t count, double r2, std::uint64_t *mask) noexcept {
+    for (std::size_t w = 0; w < (count + 63) / 64; ++w) mask[w] = 0;
+    for (std::size_t k = 0; k < count; ++k) {
+        double dx = px - xs[k];
+        double dy = py - ys[k];
+        if (dx*dx + dy*dy <= r2) mask[k / 64] |= std::uint64_t{1} << (k % 64);
+    }
+}
+
+#ifdef LAB6_HAVE_SSE2
+static void maskSSE2(double px, double py, const double *xs, const double *ys,
+                     std::size_t count, double r2, std::uint64_t *mask) noexcept {
+    const __m128d vx = _mm_set1_pd(px), vy = _mm_set1_pd(py), vr = _mm_set1_pd(r2);
+    std::size_t k = 0;
+    for (std::size_t w = 0; w < count / 64; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned s = 0; s < 64; s += 2, k += 2) {
+            __m128d dx = _mm_sub_pd(vx, _mm_loadu_pd(xs + k));
+            __m128d dy = _mm_sub_pd(vy, _mm_loadu_pd(ys + k));
+            __m128d d2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+            bits |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_cmple_pd(d2, vr))) << s;
+        }
+        mask[w] = bits;
+    }
+    if (k < count) maskScalar(px, py, xs + k, ys + k, count - k, r2, mask + k / 64);
+}
+#endif
+
+#ifdef LAB6_HAVE_AVX2
+__attribute__((target("avx2")))
+static void maskAVX2(double px, double py, const double *xs, const double *ys,
+                     std::size_t count, double r2, std::uint64_t *mask) noexcept {
+    const __m256d vx = _mm256_set1_pd(px), vy = _mm256_set1_pd(py), vr = _mm256_set1_pd(r2);
+    std::size_t k = 0;
+    for (std::size_t w = 0; w < count / 64; ++w) {
+        std::uint64_t bits = 0;
+        // two 4-lane blocks per step: 8 candidates per iteration
+        for (unsigned s = 0; s < 64; s += 8, k += 8) {
+            __m256d dx0 = _mm256_sub_pd(vx, _mm256_loadu_pd(xs + k));
+            __m256d dy0 = _mm256_sub_pd(vy, _mm256_loadu_pd(ys + k));
+            __m256d dx1 = _mm256_sub_pd(vx, _mm256_loadu_pd(xs + k + 4));
+            __m256d dy1 = _mm256_sub_pd(vy, _mm256_loadu_pd(ys + k + 4));
+            __m256d d0 = _mm256_add_pd(_mm256_mul_pd(dx0, dx0), _mm256_mul_pd(dy0, dy0));
+            __m256d d1 = _mm256_add_pd(_mm256_mul_pd(dx1, dx1), _mm256_mul_pd(dy1, dy1));
+            const unsigned m0 = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(d0, vr, _CMP_LE_OQ)));
+            const unsigned m1 = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(d1, vr, _CMP_LE_OQ)));
+            bits |= static_cast<std::uint64_t>(m0 | (m1 << 4)) << s;
+        }
+        mask[w] = bits;
+    }
+    if (k < count) maskScalar(px, py, xs + k, ys + k, count - k, r2, mask + k / 64);
+}
+#endif
+
+static DistanceKernel detectKernel() noexcept {
+#ifdef LAB6_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) return DistanceKernel::AVX2;
+#endif
+#ifdef LAB6_HAVE_SSE2
+    return DistanceKernel::SSE2;
+#else
+    return DistanceKernel::Scalar;
+#endif
+}
+
+DistanceKernel activeDistanceKernel() noexcept {
+    static const DistanceKernel k = detectKernel();
+    return k;
+}
+
+const char* distanceKernelName(DistanceKernel k) noexcept {
+    switch (k) {
+        case DistanceKernel::SSE2: return "sse2";
+        case DistanceKernel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+void inRangeMask(DistanceKernel k, double px, double py, const double *xs, const double *ys,
+                 std::size_t count, double r2, std::uint64_t *mask) noexcept {
+    // never run an instruction set the CPU lacks
+    if (static_cast<int>(k) > static_cast<int>(activeDistanceKernel())) k = activeDistanceKernel();
+    switch (k) {
+#ifdef LAB6_HAVE_AVX2
+        case DistanceKernel::AVX2: maskAVX2(px, py, xs, ys, count, r2, mask); return;
+#endif
+#ifdef LAB6_HAVE_SSE2
+        case DistanceKernel::SSE2: maskSSE2(px, py, xs, ys, count, r2, mask); return;
+#endif
+        default: maskScalar(px, py, xs, ys, count, r2, mask); return;
+    }
+}
+
+void inRangeMask(double px, double py, const double *xs, const double *ys,
+                 std::size_t count, double r2, std::uint64_t *mask) noexcept {
+    inRangeMask(activeDistanceKernel(), px, py, xs, ys, count, r2, mask);
+}
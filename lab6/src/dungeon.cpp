@@ -1,15 +1,44 @@
 #include "dungeon.hpp"
+#include "dungeon_impl.hpp"
 #include "factory.hpp"
-#include "observer.hpp"
-#include "combat_visitor.hpp"
-#include "npc.hpp"
+#include "spatial_grid.hpp"
+#include "distance_kernel.hpp"
+#include "mapped_file.hpp"
+#include "movement.hpp"
+#include "species.hpp"
 #include <fstream>
+#include <string_view>
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 
-struct Dungeon::Impl {
-    std::vector<std::unique_ptr<NPCBase>> npcs;
-    EventManager events;
+// lap timer for the CombatStats phases; never reads the clock while off
+class PhaseTimer {
+public:
+    explicit PhaseTimer(bool on) noexcept : on_(on) {
+        if (on_) last_ = Clock::now();
+    }
+
+    // nanoseconds since the previous lap, 0 while off
+    std::uint64_t lap() noexcept {
+        if (!on_) return 0;
+        const auto now = Clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count();
+        last_ = now;
+        return static_cast<std::uint64_t>(ns);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    bool on_;
+    Clock::time_point last_{};
 };
 
 Dungeon::Dungeon() : pimpl_(new Impl()) {}
@@ -17,129 +46,448 @@ Dungeon::~Dungeon() { delete pimpl_; }
 
 bool Dungeon::addNPC(std::unique_ptr<NPCBase> npc) {
     if (!npc) return false;
-    if (npc->x() < 0 || npc->x() > 500 || npc->y() < 0 || npc->y() > 500) return false;
-    auto it = std::find_if(pimpl_->npcs.begin(), pimpl_->npcs.end(),
-                           [&](auto &p){ return p->name() == npc->name(); });
-    if (it != pimpl_->npcs.end()) return false;
-    pimpl_->npcs.push_back(std::move(npc));
+    if (!inWorld(npc->x(), npc->y())) return false;
+    if (pimpl_->names.contains(npc->name())) return false;
+    pimpl_->push(std::move(npc));
     return true;
 }
 
+bool Dungeon::removeNPC(const std::string &name) {
+    const size_t slot = pimpl_->slotOf(name);
+    if (slot == pimpl_->npcs.size()) return false;
+    pimpl_->bury(slot);
+    pimpl_->maybeCompact();
+    return true;
+}
+
+bool Dungeon::contains(const std::string &name) const noexcept {
+    return pimpl_->names.contains(name);
+}
+
+const NPCBase* Dungeon::Impl::npcAt(size_t slot) {
+    std::lock_guard<std::mutex> lock(npcMutex);
+    std::unique_ptr<NPCBase> &npc = npcs[slot];
+    if (!npc) {
+        npc = NPCFactory::create(cols.kind[slot], names.view(cols.nameId[slot]), cols.x[slot], cols.y[slot], pool.get());
+        npc->bind(&cols, static_cast<std::uint32_t>(slot));
+    }
+    return npc.get();
+}
+
+const NPCBase* Dungeon::find(const std::string &name) const {
+    const size_t slot = pimpl_->slotOf(name);
+    return slot == pimpl_->npcs.size() ? nullptr : pimpl_->npcAt(slot);
+}
+
+NPCHandle Dungeon::handleOf(const std::string &name) const noexcept {
+    const size_t slot = pimpl_->slotOf(name);
+    return slot == pimpl_->npcs.size() ? NPCHandle{} : pimpl_->cols.handle[slot];
+}
+
+std::string_view Dungeon::nameOf(NPCHandle h) const noexcept {
+    return pimpl_->nameOf(h);
+}
+
+const NPCBase* Dungeon::find(NPCHandle h) const {
+    const size_t slot = pimpl_->slotOf(h);
+    if (slot == pimpl_->npcs.size() || pimpl_->cols.tomb[slot]) return nullptr;
+    return pimpl_->npcAt(slot);
+}
+
+size_t Dungeon::size() const noexcept {
+    return pimpl_->live;
+}
+
 bool Dungeon::loadFromFile(const std::string &fname) {
-    std::ifstream f(fname);
-    if (!f) return false;
-    std::string line;
-    std::vector<std::unique_ptr<NPCBase>> newlist;
-    while (std::getline(f, line)) {
+    MappedFile f;
+    if (!f.open(fname)) return false;
+    const std::string_view text = f.data();
+
+    // the file replaces the current roster; duplicates are checked against
+    // the name index as lines come in
+    pimpl_->reset();
+    pimpl_->reserve(static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1);
+
+    NPCRecord rec;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        const std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
         if (line.empty()) continue;
-        auto npc = NPCFactory::createFromLine(line);
+        if (!NPCFactory::parseLine(line, rec)) continue;
+        if (!inWorld(rec.x, rec.y)) continue;
+        if (pimpl_->names.contains(rec.name)) continue;
+        auto npc = NPCFactory::create(rec.type, rec.name, rec.x, rec.y, pimpl_->pool.get());
         if (!npc) continue;
-        if (npc->x() < 0 || npc->x() > 500 || npc->y() < 0 || npc->y() > 500) continue;
-        bool dup = std::any_of(newlist.begin(), newlist.end(), [&](auto &p){ return p->name() == npc->name(); });
-        if (dup) continue;
-        newlist.push_back(std::move(npc));
+        pimpl_->push(std::move(npc));
     }
-    pimpl_->npcs = std::move(newlist);
     return true;
 }
 
 bool Dungeon::saveToFile(const std::string &fname) const {
     std::ofstream f(fname);
     if (!f) return false;
-    for (auto &p : pimpl_->npcs) {
-        f << p->type() << " " << p->name() << " " << p->x() << " " << p->y() << "\n";
+    const NPCColumns &cols = pimpl_->cols;
+    for (size_t i = 0; i < cols.size(); ++i) {
+        if (cols.tomb[i]) continue;
+        f << kindName(cols.kind[i]) << " " << pimpl_->names.view(cols.nameId[i]) << " "
+          << cols.x[i] << " " << cols.y[i] << "\n";
     }
     return true;
 }
 
 void Dungeon::clear() noexcept {
-    pimpl_->npcs.clear();
+    pimpl_->reset();
+}
+
+void Dungeon::compact() {
+    pimpl_->compact();
+}
+
+void Dungeon::setCompactionThreshold(double fraction) noexcept {
+    pimpl_->compactFraction = fraction >= 0.0 ? fraction : 0.0;
 }
 
 void Dungeon::printAll() const {
-    std::cout << "--- NPCs (" << pimpl_->npcs.size() << ") ---\n";
-    for (auto &p : pimpl_->npcs) {
-        std::cout << p->type() << " " << p->name() << " (" << p->x() << "," << p->y() << ")";
-        if (!p->alive()) std::cout << " [dead]";
+    std::cout << "--- NPCs (" << pimpl_->live << ") ---\n";
+    const NPCColumns &cols = pimpl_->cols;
+    for (size_t i = 0; i < cols.size(); ++i) {
+        if (cols.tomb[i]) continue;
+        std::cout << kindName(cols.kind[i]) << " " << pimpl_->names.view(cols.nameId[i])
+                  << " (" << cols.x[i] << "," << cols.y[i] << ")";
+        if (!cols.alive[i]) std::cout << " [dead]";
         std::cout << "\n";
     }
 }
 
+NPCPool* Dungeon::pool() noexcept {
+    return pimpl_->pool.get();
+}
+
 EventManager& Dungeon::events() noexcept {
     return pimpl_->events;
 }
 
+void Dungeon::setThreads(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == this->threads()) return;
+    pimpl_->threads = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+}
+
+unsigned Dungeon::threads() const noexcept {
+    return pimpl_->threads ? pimpl_->threads->size() : 1;
+}
+
+// true if some NPC left in the dungeon can kill another one, judging by
+// species alone (a species that kills its own kind needs two members)
+static bool anyoneCanKill(const NPCColumns &cols) noexcept {
+    size_t count[kNPCKindCount] = {};
+    for (size_t i = 0; i < cols.size(); ++i) {
+        const auto k = static_cast<size_t>(cols.kind[i]);
+        if (cols.alive[i] && k < kNPCKindCount) ++count[k];
+    }
+    for (size_t a = 0; a < kNPCKindCount; ++a)
+        for (size_t v = 0; v < kNPCKindCount; ++v)
+            if (kKillMatrix[a][v] && count[a] > 0 && count[v] > (a == v ? 1u : 0u)) return true;
+    return false;
+}
+
 void Dungeon::runCombat(double range) {
-    if (range < 0.0) return;
-    const double r2 = range * range;
+    if (!(range >= 0.0)) return;
+    pimpl_->combatRound(range);
+}
+
+void Dungeon::enableStats(bool on) noexcept {
+    pimpl_->statsOn = on;
+}
+
+bool Dungeon::statsEnabled() const noexcept {
+    return pimpl_->statsOn;
+}
 
-    auto &npcs = pimpl_->npcs;
-    size_t n = npcs.size();
-    if (n < 2) return;
+const CombatStats& Dungeon::stats() const noexcept {
+    return pimpl_->stats;
+}
 
-    std::vector<char> aliveAtStart(n, 0);
-    for (size_t i = 0; i < n; ++i) aliveAtStart[i] = npcs[i]->alive() ? 1 : 0;
+void Dungeon::resetStats() noexcept {
+    pimpl_->stats = CombatStats{};
+}
 
-    std::vector<char> willDie(n, 0);
+// moveDistance() for every value the kind byte can hold, so the move loop
+// looks a limit up without a bounds check
+static constexpr auto kStepLimit = [] {
+    std::array<double, 256> limits{};
+    for (size_t k = 0; k < limits.size(); ++k) limits[k] = moveDistance(static_cast<NPCKind>(k));
+    return limits;
+}();
 
-    // store first killer for each victim (empty => not yet killed/logged)
-    std::vector<std::string> killerOf(n);
+// v clamped to [0, kWorldSize]; NaN gives `fallback`
+static double clampToWorld(double v, double fallback) noexcept {
+    const double clamped = std::min(std::max(v, 0.0), kWorldSize);
+    return v == v ? clamped : fallback;
+}
 
-    // events in this round (we will notify AFTER applying deaths)
-    struct Ev { std::string killer; std::string victim; double x; double y; };
-    std::vector<Ev> events;
+size_t Dungeon::move(IMovementPolicy &policy) {
+    NPCColumns &cols = pimpl_->cols;
+    MoveScratch &mv = pimpl_->movement;
+    const size_t n = cols.size();
+    mv.dx.assign(n, 0.0);
+    mv.dy.assign(n, 0.0);
+    policy.steps({cols.x, cols.y, cols.kind}, mv.dx, mv.dy);
 
-    // evaluate all unordered pairs (i<j) using aliveAtStart snapshot
+    // target positions, computed over whole columns; a step longer than the
+    // kind's move distance is shortened to it. The scale and the clamp are
+    // selects, not branches, so the loop vectorizes (-O3 -fno-math-errno)
+    double *xs = cols.x.data(), *ys = cols.y.data();
+    double *nx = mv.dx.data(), *ny = mv.dy.data();
+    const NPCKind *kinds = cols.kind.data();
     for (size_t i = 0; i < n; ++i) {
-        if (!aliveAtStart[i]) continue; // dead at start -> doesn't participate
-        for (size_t j = i + 1; j < n; ++j) {
-            if (!aliveAtStart[j]) continue;
-
-            double dx = npcs[i]->x() - npcs[j]->x();
-            double dy = npcs[i]->y() - npcs[j]->y();
-            if (dx*dx + dy*dy > r2) continue;
-
-            // i attacks j
-            CombatVisitor cv_i(npcs[i].get());
-            npcs[j]->accept(cv_i);
-            if (cv_i.victimDies()) {
-                // record willDie even if already marked; but only first killer is logged
-                willDie[j] = 1;
-                if (killerOf[j].empty()) {
-                    killerOf[j] = npcs[i]->name();
-                    events.push_back({npcs[i]->name(), npcs[j]->name(), npcs[j]->x(), npcs[j]->y()});
-                }
-            }
-            if (cv_i.attackerDies()) {
-                // j would kill i (in reaction)
-                willDie[i] = 1;
-                if (killerOf[i].empty()) {
-                    killerOf[i] = npcs[j]->name();
-                    events.push_back({npcs[j]->name(), npcs[i]->name(), npcs[i]->x(), npcs[i]->y()});
-                }
-            }
+        const double limit = kStepLimit[static_cast<std::uint8_t>(kinds[i])];
+        const double len = std::sqrt(nx[i] * nx[i] + ny[i] * ny[i]);
+        // 1 unless the step is too long; 0/0 for a zero step at a zero
+        // limit, which the clamp's NaN fallback turns into staying put
+        const double scale = limit / std::max(len, limit);
+        nx[i] *= scale;
+        ny[i] *= scale;
+        nx[i] = clampToWorld(xs[i] + nx[i], xs[i]);
+        ny[i] = clampToWorld(ys[i] + ny[i], ys[i]);
+    }
+
+    // commit, marking the NPCs that really moved for the next round
+    mv.moved.clear();
+    for (size_t i = 0; i < n; ++i) {
+        if ((nx[i] == xs[i] && ny[i] == ys[i]) || cols.tomb[i]) continue;
+        xs[i] = nx[i];
+        ys[i] = ny[i];
+        cols.dirty[i] = 1;
+        mv.moved.push_back(static_cast<std::uint32_t>(i));
+    }
+    if (pimpl_->combat.gridValid) {
+        for (SpatialGrid &grid : pimpl_->combat.grids) grid.update(cols.x, cols.y, mv.moved);
+    }
+    return mv.moved.size();
+}
+
+SimulationResult Dungeon::simulate(double range, size_t maxRounds, IMovementPolicy *movement) {
+    SimulationResult result;
+    if (!(range >= 0.0)) return result;
+    if (movement && maxRounds == untilStable)
+        throw std::invalid_argument("Dungeon::simulate: a movement policy needs a round cap");
+    while (maxRounds == untilStable || result.rounds.size() < maxRounds) {
+        if (!anyoneCanKill(pimpl_->cols)) {
+            result.stable = true;
+            break;
+        }
+        const size_t moved = movement ? move(*movement) : 0;
+        const size_t deaths = pimpl_->combatRound(range);
+        result.rounds.push_back({deaths, pimpl_->live, moved});
+        if (deaths == 0 && moved == 0) {
+            result.stable = true;
+            break;
+        }
+    }
+    return result;
+}
+
+size_t Dungeon::Impl::combatRound(double range) {
+    const double r2 = range * range;
 
-            // Note: we evaluate both directions implicitly because when later i/j
-            // swap roles (we don't evaluate j attacking i separately here). If you want
-            // both A vs B and B vs A to be considered as separate attacker roles, keep this loop
-            // because cv_i.attackerDies() covers mutual kills as determined by visitor.
+    size_t n = cols.size();
+    if (n < 2) return 0;
+    PhaseTimer timer(statsOn);
+    if (statsOn) ++stats.rounds;
+
+    // nothing changes cols.alive before the deaths are applied, so the
+    // column itself serves as the aliveAtStart snapshot
+    const std::uint8_t *aliveAtStart = cols.alive.data();
+    const double *xs = cols.x.data();
+    const double *ys = cols.y.data();
+    const NPCKind *kinds = cols.kind.data();
+
+    // Incremental round: clean pairs within cleanRange cannot fight, so only
+    // pairs with a dirty member need testing, scanned from the dirty side.
+    // A wider range than last time, or a mostly dirty map, gets a full scan.
+    // NPCs that were added dead are dirty too; they leave at the end of the
+    // round like the ones killed in it.
+    std::vector<std::uint32_t> &rows = combat.rows;
+    std::vector<std::uint32_t> &deadRows = combat.deadRows;
+    rows.clear();
+    deadRows.clear();
+    for (size_t i = 0; i < n; ++i) {
+        if (!cols.dirty[i]) continue;
+        (aliveAtStart[i] ? rows : deadRows).push_back(static_cast<std::uint32_t>(i));
+    }
+    const bool full = range > cleanRange || rows.size() * 2 > live;
+    if (!full && rows.empty() && deadRows.empty()) {
+        // nothing changed since a round at this range or wider
+        events.publish({});
+        stats.snapshotNs += timer.lap();
+        return 0;
+    }
+    cleanRange = range;
+    const std::uint8_t *dirtyAtStart = cols.dirty.data();
+
+    // Species are indexed separately, so a row only visits the species it
+    // can fight (or be killed by): Squirrels never test Squirrels, Bears
+    // never test Bears. Only cells next to an attacker's cell can hold NPCs
+    // within range. The grids are kept from the last round if no NPC was
+    // added or removed since; moves update them in place.
+    auto &grids = combat.grids;
+    if (!combat.gridValid || grids[0].range() != range) {
+        for (auto &m : combat.members) m.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const auto k = static_cast<size_t>(kinds[i]);
+            if (k < kNPCKindCount) combat.members[k].push_back(static_cast<std::uint32_t>(i));
         }
+        for (size_t k = 0; k < kNPCKindCount; ++k)
+            grids[k].build(cols.x, cols.y, combat.members[k], range, kWorldSize);
     }
+    combat.gridValid = true;
 
-    // apply deaths (mark dead) — but do it once per victim
-    for (size_t idx = 0; idx < n; ++idx) {
-        if (willDie[idx] && npcs[idx]->alive()) {
-            npcs[idx]->markDead();
+    // scans[a][b]: rows of species a search the grid of species b. A full
+    // scan meets each pair of two different species from one side only,
+    // the species with fewer members; pairs of one species and the pairs
+    // of an incremental round are seen from both ends and kept once below.
+    bool scans[kNPCKindCount][kNPCKindCount] = {};
+    for (size_t a = 0; a < kNPCKindCount; ++a) {
+        for (size_t b = 0; b < kNPCKindCount; ++b) {
+            if (!canFight(static_cast<NPCKind>(a), static_cast<NPCKind>(b))) continue;
+            const size_t na = grids[a].size(), nb = grids[b].size();
+            scans[a][b] = !full || a == b || na < nb || (na == nb && a < b);
         }
     }
+    stats.snapshotNs += timer.lap();
 
-    // notify events (each victim logged only once, as collected)
-    for (auto &ev : events) {
-        pimpl_->events.notify({ev.killer, ev.victim, ev.x, ev.y});
+    // rank of the first killer for each victim (kNoKiller => not killed this
+    // round); kills may be found concurrently, keeping the minimum makes the
+    // result independent of scheduling
+    std::vector<std::uint64_t> &killerOf = combat.killerOf;
+    killerOf.assign(n, kNoKiller);
+    auto recordKill = [&](size_t killer, size_t victim) {
+        const std::uint64_t rank = killRank(killer, victim, n);
+        std::atomic_ref<std::uint64_t> best(killerOf[victim]);
+        std::uint64_t cur = best.load(std::memory_order_relaxed);
+        while (rank < cur && !best.compare_exchange_weak(cur, rank, std::memory_order_relaxed)) {}
+    };
+
+    // evaluate unordered in-range pairs using aliveAtStart snapshot, each pair
+    // once: in a full scan from row min(i, j) within a species and from the
+    // smaller species across two; otherwise from its dirty member (the lower
+    // one if both are dirty). The distance test runs over the grids'
+    // cell-ordered coordinates.
+    ThreadPool *pool = threads.get();
+    auto &masks = combat.masks;
+    masks.resize(pool ? pool->size() : 1);
+    for (auto &mask : masks) {
+        if (mask.size() < (n + 63) / 64) mask.resize((n + 63) / 64);
     }
+    auto &counts = combat.counts;
+    if (statsOn) counts.assign(masks.size(), ScanCounts{});
+
+    // `count` is std::true_type while stats are on, so the counting code is
+    // compiled out of the usual scan
+    auto scanRows = [&](size_t rowBegin, size_t rowEnd, unsigned worker, auto count) {
+        constexpr bool kCount = decltype(count)::value;
+        auto &mask = masks[worker];
+        ScanCounts *c = kCount ? &counts[worker] : nullptr;
+        for (size_t r = rowBegin; r < rowEnd; ++r) {
+            const size_t i = full ? r : rows[r];
+            if (!aliveAtStart[i]) continue; // dead at start -> doesn't participate
+            const auto own = static_cast<size_t>(kinds[i]);
+            if (own >= kNPCKindCount) continue;
+            for (size_t other = 0; other < kNPCKindCount; ++other) {
+                if (!scans[own][other]) continue;
+                // within a species a full scan keeps pairs at their lower row
+                const bool lowerRowOnly = full && own == other;
+                const SpatialGrid &grid = grids[other];
+                const std::uint32_t *cellItems = grid.items();
+                grid.forEachNearRun(xs[i], ys[i], [&](std::uint32_t b, std::uint32_t e) {
+                    inRangeMask(xs[i], ys[i], grid.xs() + b, grid.ys() + b, e - b, r2, mask.data());
+                    if constexpr (kCount) c->examined += e - b;
+                    for (size_t w = 0; w < (e - b + 63) / 64; ++w) {
+                        for (std::uint64_t bits = mask[w]; bits; bits &= bits - 1) {
+                            const size_t j = cellItems[b + w * 64 + std::countr_zero(bits)];
+                            if (j == i || !aliveAtStart[j]) continue;
+                            if (j < i && (lowerRowOnly || (!full && dirtyAtStart[j]))) continue;   // row j has it
 
-    // remove dead NPCs
-    npcs.erase(std::remove_if(npcs.begin(), npcs.end(),
-                [](const std::unique_ptr<NPCBase> &p){ return !p->alive(); }),
-               npcs.end());
+                            // lo attacks hi, and hi may kill lo in reaction
+                            const size_t lo = std::min(i, j), hi = std::max(i, j);
+                            const bool loKills = kills(kinds[lo], kinds[hi]);
+                            const bool hiKills = kills(kinds[hi], kinds[lo]);
+                            if (loKills) recordKill(lo, hi);
+                            if (hiKills) recordKill(hi, lo);
+                            if constexpr (kCount) {
+                                ++c->inRange;
+                                c->kills += loKills + hiKills;
+                            }
+                        }
+                    }
+                });
+            }
+        }
+    };
+    const size_t rowCount = full ? n : rows.size();
+    auto runScan = [&](auto count) {
+        if (pool) {
+            pool->parallelFor(rowCount, kCombatGrain, [&](size_t b, size_t e, unsigned w) {
+                scanRows(b, e, w, count);
+            });
+        } else {
+            scanRows(0, rowCount, 0, count);
+        }
+    };
+    if (statsOn) runScan(std::true_type{});
+    else runScan(std::false_type{});
+    if (statsOn) {
+        for (const ScanCounts &c : counts) {
+            stats.pairsExamined += c.examined;
+            stats.pairsInRange += c.inRange;
+            stats.kills += c.kills;
+        }
+    }
+    stats.scanNs += timer.lap();
+
+    // events in this round, in the order a full i<j pair scan would log them
+    std::vector<size_t> &victims = combat.victims;
+    victims.clear();
+    for (size_t v = 0; v < n; ++v) {
+        if (killerOf[v] != kNoKiller) victims.push_back(v);
+    }
+    auto killer = [&](size_t v) { return killerFromRank(killerOf[v], n); };
+    std::sort(victims.begin(), victims.end(), [&](size_t a, size_t b) {
+        return eventKey(killer(a), a) < eventKey(killer(b), b);
+    });
+
+    // apply deaths; bound NPC objects read their liveness from the columns
+    for (size_t v : victims) cols.alive[v] = 0;
+
+    stats.applyNs += timer.lap();
+
+    // publish the round's events as one batch (each victim logged only once);
+    // events carry handles, so once the buffer has grown this allocates
+    // nothing. The dead are buried only afterwards: their names still
+    // resolve while observers run.
+    std::vector<DeathEvent> &roundEvents = combat.events;
+    roundEvents.clear();
+    for (size_t v : victims) roundEvents.push_back({cols.handle[killer(v)], cols.handle[v], xs[v], ys[v]});
+    events.publish(roundEvents);
+    stats.notifyNs += timer.lap();
+
+    // every survivor has now been seen at this range
+    if (full) std::fill(cols.dirty.begin(), cols.dirty.end(), std::uint8_t{0});
+    else for (std::uint32_t i : rows) cols.dirty[i] = 0;
+
+    // the dead become tombstones; slots move only once enough have piled up
+    for (size_t v : victims) bury(v);
+    for (std::uint32_t v : deadRows) bury(v);
+    maybeCompact();
+    if (statsOn) {
+        stats.events += victims.size();
+        stats.removed += victims.size() + deadRows.size();
+        stats.eraseNs += timer.lap();
+    }
+    return victims.size();
 }
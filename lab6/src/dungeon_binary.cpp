@@ -0,0 +1,188 @@
+#include "dungeon.hpp"
+#include "dungeon_impl.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+// Snapshot layout (native byte order, checked through byteOrder):
+//
+//   SnapshotHeader
+//   kind      uint8[count]
+//   alive     uint8[count]
+//   x         double[count]
+//   y         double[count]
+//   nameEnd   uint64[count]    end offset of each name in the string table
+//   names     char[nameBytes]  names back to back, no terminators
+//
+// Every section starts at a multiple of 8 bytes so the columns can be read
+// in place from the mapping.
+
+static constexpr char kMagic[8] = {'L', 'A', 'B', '6', 'S', 'N', 'P', '\0'};
+static constexpr std::uint32_t kVersion = 1;
+static constexpr std::uint32_t kByteOrder = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t count;
+    std::uint64_t kindOff, aliveOff, xOff, yOff, nameEndOff, namesOff;
+    std::uint64_t nameBytes;
+};
+
+static std::uint64_t align8(std::uint64_t v) noexcept { return (v + 7) & ~std::uint64_t{7}; }
+
+static SnapshotHeader layout(std::uint64_t count, std::uint64_t nameBytes) noexcept {
+    SnapshotHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version = kVersion;
+    h.byteOrder = kByteOrder;
+    h.count = count;
+    h.kindOff = align8(sizeof(SnapshotHeader));
+    h.aliveOff = align8(h.kindOff + count);
+    h.xOff = align8(h.aliveOff + count);
+    h.yOff = h.xOff + count * sizeof(double);
+    h.nameEndOff = h.yOff + count * sizeof(double);
+    h.namesOff = h.nameEndOff + count * sizeof(std::uint64_t);
+    h.nameBytes = nameBytes;
+    return h;
+}
+
+static void writeAt(std::ofstream &f, std::uint64_t off, const void *data, std::uint64_t bytes) {
+    f.seekp(static_cast<std::streamoff>(off));
+    f.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+}
+
+bool Dungeon::saveBinary(const std::string &fname) const {
+    const NPCColumns &cols = pimpl_->cols;
+
+    // tombstones are not part of the roster; with none around the columns
+    // are written as they are, otherwise the live slots are gathered first
+    std::vector<std::uint32_t> liveSlots;
+    const bool dense = pimpl_->tombs == 0;
+    if (!dense) {
+        liveSlots.reserve(pimpl_->live);
+        for (size_t i = 0; i < cols.size(); ++i) {
+            if (!cols.tomb[i]) liveSlots.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    const size_t n = dense ? cols.size() : liveSlots.size();
+    auto slot = [&](size_t k) -> size_t { return dense ? k : liveSlots[k]; };
+
+    std::vector<std::uint64_t> nameEnd(n);
+    std::uint64_t nameBytes = 0;
+    for (size_t k = 0; k < n; ++k) {
+        nameBytes += pimpl_->names.view(cols.nameId[slot(k)]).size();
+        nameEnd[k] = nameBytes;
+    }
+    const SnapshotHeader h = layout(n, nameBytes);
+    // the string table is gathered and written in one piece
+    auto names = std::make_unique_for_overwrite<char[]>(static_cast<size_t>(nameBytes));
+    for (size_t k = 0; k < n; ++k) {
+        const std::string_view name = pimpl_->names.view(cols.nameId[slot(k)]);
+        std::memcpy(names.get() + (nameEnd[k] - name.size()), name.data(), name.size());
+    }
+
+    std::ofstream f(fname, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    auto writeColumn = [&](std::uint64_t off, const auto &col) {
+        using T = typename std::decay_t<decltype(col)>::value_type;
+        if (dense) {
+            writeAt(f, off, col.data(), n * sizeof(T));
+            return;
+        }
+        std::vector<T> packed(n);
+        for (size_t k = 0; k < n; ++k) packed[k] = col[liveSlots[k]];
+        writeAt(f, off, packed.data(), n * sizeof(T));
+    };
+    writeAt(f, 0, &h, sizeof h);
+    static_assert(sizeof(NPCKind) == 1);
+    writeColumn(h.kindOff, cols.kind);
+    writeColumn(h.aliveOff, cols.alive);
+    writeColumn(h.xOff, cols.x);
+    writeColumn(h.yOff, cols.y);
+    writeAt(f, h.nameEndOff, nameEnd.data(), n * sizeof(std::uint64_t));
+    writeAt(f, h.namesOff, names.get(), nameBytes);
+    return static_cast<bool>(f.flush());
+}
+
+bool Dungeon::loadBinary(const std::string &fname) {
+    MappedFile f;
+    if (!f.open(fname)) return false;
+    const std::string_view data = f.data();
+
+    SnapshotHeader h;
+    if (data.size() < sizeof h) return false;
+    std::memcpy(&h, data.data(), sizeof h);
+    if (std::memcmp(h.magic, kMagic, sizeof kMagic) != 0 || h.version != kVersion || h.byteOrder != kByteOrder)
+        return false;
+    // every section must sit where this version puts it and inside the file
+    if (h.count > data.size() || h.nameBytes > data.size()) return false;
+    const SnapshotHeader want = layout(h.count, h.nameBytes);
+    if (std::memcmp(&h, &want, sizeof h) != 0 || h.namesOff + h.nameBytes > data.size()) return false;
+
+    const size_t n = static_cast<size_t>(h.count);
+    const char *base = data.data();
+    auto kinds = reinterpret_cast<const NPCKind*>(base + h.kindOff);
+    auto alive = reinterpret_cast<const std::uint8_t*>(base + h.aliveOff);
+    auto xs = reinterpret_cast<const double*>(base + h.xOff);
+    auto ys = reinterpret_cast<const double*>(base + h.yOff);
+    auto nameEnd = reinterpret_cast<const std::uint64_t*>(base + h.nameEndOff);
+    const char *names = base + h.namesOff;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (nameEnd[i] < (i ? nameEnd[i - 1] : 0) || nameEnd[i] > h.nameBytes) return false;
+    }
+
+    // same rules as addNPC: bad kinds, out-of-world coordinates, empty and
+    // repeated names are skipped (names.assign drops the repeats)
+    std::vector<std::uint8_t> take(n);
+    for (size_t i = 0; i < n; ++i) {
+        const bool named = nameEnd[i] != (i ? nameEnd[i - 1] : 0);
+        take[i] = named && static_cast<size_t>(kinds[i]) < kNPCKindCount && inWorld(xs[i], ys[i]);
+    }
+    pimpl_->reset();
+    pimpl_->names.assign({names, static_cast<size_t>(h.nameBytes)}, {nameEnd, n}, take);
+    const size_t m = static_cast<size_t>(std::count(take.begin(), take.end(), std::uint8_t{1}));
+    if (m > size_t{NPCHandle::kMaxIndex} + 1) {
+        pimpl_->reset();
+        throw std::length_error("Dungeon: too many NPCs");
+    }
+
+    // the columns are copied whole when every record is kept; name ids are
+    // record indices, and the NPC objects are left to npcAt()
+    NPCColumns &cols = pimpl_->cols;
+    auto fill = [&](auto &col, const auto *src) {
+        if (m == n) {
+            col.assign(src, src + n);
+            return;
+        }
+        col.clear();
+        col.reserve(m);
+        for (size_t i = 0; i < n; ++i) {
+            if (take[i]) col.push_back(src[i]);
+        }
+    };
+    fill(cols.x, xs);
+    fill(cols.y, ys);
+    fill(cols.kind, kinds);
+    fill(cols.alive, alive);
+    for (std::uint8_t &a : cols.alive) a = a != 0;   // any nonzero byte reads as alive
+    cols.dirty.assign(m, 1);
+    cols.tomb.assign(m, 0);
+    cols.nameId.resize(m);
+    pimpl_->slotOfName.assign(n, 0);
+    for (size_t i = 0, slot = 0; i < n; ++i) {
+        if (!take[i]) continue;
+        cols.nameId[slot] = static_cast<std::uint32_t>(i);
+        pimpl_->slotOfName[i] = static_cast<std::uint32_t>(slot);
+        ++slot;
+    }
+    cols.handle.resize(m);
+    pimpl_->acquireHandles(0, m, cols.handle.data());
+    pimpl_->npcs.resize(m);
+    pimpl_->live = m;
+    return true;
+}
@@ -0,0 +1,19 @@
+#include "dungeon.hpp"
+#include "dungeon_impl.hpp"
+#include "factory.hpp"
+#include "world_generator.hpp"
+
+size_t Dungeon::generate(const WorldSpec &spec) {
+    pimpl_->reserve(pimpl_->npcs.size() + spec.count);
+
+    WorldGenerator gen(spec);
+    GeneratedNPC g;
+    size_t added = 0;
+    while (gen.next(g)) {
+        const std::string name = generatedName(spec, g.index);
+        if (pimpl_->names.contains(name)) continue;
+        pimpl_->push(NPCFactory::create(g.kind, name, g.x, g.y, pimpl_->pool.get()));
+        ++added;
+    }
+    return added;
+}
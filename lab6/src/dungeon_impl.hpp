@@ -0,0 +1,265 @@
+#pragma once
+// Private to the library: Dungeon's state, shared by the translation units
+// that implement Dungeon (dungeon.cpp, dungeon_binary.cpp, dungeon_generate.cpp,
+// dungeon_sweep.cpp).
+#include "dungeon.hpp"
+#include "npc.hpp"
+#include "npc_columns.hpp"
+#include "npc_pool.hpp"
+#include "name_table.hpp"
+#include "observer.hpp"
+#include "spatial_grid.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+inline constexpr double kWorldSize = 500.0;
+
+inline bool inWorld(double x, double y) noexcept {
+    return x >= 0 && x <= kWorldSize && y >= 0 && y <= kWorldSize;
+}
+
+// hands the pool back when the dungeon goes away; blocks still held by
+// NPCs outside the dungeon keep it alive until they are destroyed
+struct PoolRelease {
+    void operator()(NPCPool *p) const noexcept { p->release(); }
+};
+
+inline constexpr std::uint64_t kNoKiller = std::numeric_limits<std::uint64_t>::max();
+inline constexpr size_t kCombatGrain = 256;   // attacker rows per parallel chunk
+
+// A full scan visits pairs (i, j), i < j, in lexicographic order and within a
+// pair logs "j dies" before "i dies". These helpers reproduce that order.
+//
+// For one victim, pairs (k, victim) with k < victim all come before any pair
+// (victim, k), so ranking killers as below makes the first killer the one
+// with the lowest rank - no matter in which order kills are discovered.
+inline std::uint64_t killRank(size_t killer, size_t victim, size_t n) noexcept {
+    return killer < victim ? killer : n + killer;
+}
+
+inline size_t killerFromRank(std::uint64_t rank, size_t n) noexcept {
+    return static_cast<size_t>(rank < n ? rank : rank - n);
+}
+
+inline std::tuple<size_t, size_t, bool> eventKey(size_t killer, size_t victim) noexcept {
+    return {std::min(killer, victim), std::max(killer, victim), victim < killer};
+}
+
+// per-worker CombatStats counters, on separate cache lines
+struct alignas(64) ScanCounts {
+    std::uint64_t examined = 0;
+    std::uint64_t inRange = 0;
+    std::uint64_t kills = 0;
+};
+
+// buffers of one combat round; they live as long as the dungeon, so repeated
+// rounds reuse their capacity instead of allocating again
+struct CombatScratch {
+    std::array<SpatialGrid, kNPCKindCount> grids;     // one per species, indexing its slots
+    std::array<std::vector<std::uint32_t>, kNPCKindCount> members;   // grid build scratch
+    std::vector<std::uint64_t> killerOf;              // victim -> rank of first killer
+    std::vector<std::vector<std::uint64_t>> masks;    // distance mask, one per worker
+    std::vector<size_t> victims;
+    std::vector<DeathEvent> events;                   // the round's batch
+    std::vector<std::uint32_t> rows;                  // dirty attackers of an incremental round
+    std::vector<std::uint32_t> deadRows;              // dirty NPCs that were added dead
+    std::vector<ScanCounts> counts;                   // one per worker, used while stats are on
+    bool gridValid = false;                           // grids match the columns' slots
+};
+
+// buffers of one movement tick
+struct MoveScratch {
+    std::vector<double> dx, dy;
+    std::vector<std::uint32_t> moved;                 // slots whose position changed
+};
+
+// entry of the handle table
+struct HandleEntry {
+    std::uint32_t slot = 0;       // cols slot of the NPC holding the entry
+    std::uint8_t generation = 1;  // bumped when the NPC leaves; never 0
+};
+
+// The Impl is the name source of its own EventManager: handles resolve to
+// names until the NPC's tombstone is compacted away.
+struct Dungeon::Impl final : INameSource {
+    std::unique_ptr<NPCPool, PoolRelease> pool{new NPCPool};   // declared first, destroyed last
+    NPCColumns cols;                              // hot data, streamed by combat
+    NameTable names;
+    std::vector<std::uint32_t> slotOfName;        // name id -> cols slot
+    std::vector<HandleEntry> handles;             // NPCHandle::index() -> entry
+    std::vector<std::uint32_t> freeHandles;       // entries without an NPC
+    // npcs[i] is bound to cols slot i; loadBinary leaves them null, npcAt()
+    // makes one on first lookup
+    std::vector<std::unique_ptr<NPCBase>> npcs;
+    std::mutex npcMutex;                          // held by npcAt(), which const lookups call
+    EventManager events;
+    std::unique_ptr<ThreadPool> threads;          // null => combat runs serially
+    std::mutex sweepPoolMutex;                    // held by a sweepCombat using `threads`
+    CombatScratch combat;
+    MoveScratch movement;
+    bool statsOn = false;
+    CombatStats stats;
+    // Every pair of clean NPCs (dirty == 0) within cleanRange is known not
+    // to fight: the last round saw both of them and killed neither. Deaths
+    // and removals only take pairs away, so they leave this intact.
+    double cleanRange = std::numeric_limits<double>::infinity();
+
+    // Removed NPCs stay in their slot as tombstones (tomb = 1, alive = 0,
+    // name unindexed but still resolvable through the handle) until
+    // compaction drops them in one pass. Slots only
+    // move during compaction, which runs once tombstones make up more than
+    // compactFraction of the slots, or on request.
+    size_t live = 0;                              // slots that are not tombstones
+    size_t tombs = 0;
+    double compactFraction = 0.25;
+
+    Impl() { events.setNameSource(this); }
+
+    // one combat round at range (>= 0); returns the number of NPCs killed
+    size_t combatRound(double range);
+
+    // the NPC object of a slot, made and bound first if it has none yet
+    const NPCBase* npcAt(size_t slot);
+
+    std::string_view nameOf(NPCHandle h) const noexcept override {
+        const size_t slot = slotOf(h);
+        return slot == npcs.size() ? std::string_view{} : names.view(cols.nameId[slot]);
+    }
+
+    // slot of a handle's NPC (a tombstone, possibly), npcs.size() if stale
+    size_t slotOf(NPCHandle h) const noexcept {
+        const std::uint32_t index = h.index();
+        if (!h || index >= handles.size() || handles[index].generation != h.generation()) return npcs.size();
+        return handles[index].slot;
+    }
+
+    NPCHandle acquireHandle(std::uint32_t slot) {
+        std::uint32_t index;
+        if (!freeHandles.empty()) {
+            index = freeHandles.back();
+            freeHandles.pop_back();
+        } else {
+            if (handles.size() > NPCHandle::kMaxIndex) throw std::length_error("Dungeon: too many NPCs");
+            index = static_cast<std::uint32_t>(handles.size());
+            handles.emplace_back();
+            // releaseHandle never allocates
+            if (freeHandles.capacity() < handles.size()) freeHandles.reserve(handles.capacity());
+        }
+        handles[index].slot = slot;
+        return NPCHandle::make(index, handles[index].generation);
+    }
+
+    // handles for `count` NPCs in slots first, first + 1, ...; like calling
+    // acquireHandle for each, but the table grows once
+    void acquireHandles(std::uint32_t first, size_t count, NPCHandle *out) {
+        size_t k = 0;
+        for (; k < count && !freeHandles.empty(); ++k) out[k] = acquireHandle(first + static_cast<std::uint32_t>(k));
+        const size_t base = handles.size();
+        if (base + (count - k) > size_t{NPCHandle::kMaxIndex} + 1) throw std::length_error("Dungeon: too many NPCs");
+        handles.resize(base + (count - k));
+        if (freeHandles.capacity() < handles.size()) freeHandles.reserve(handles.capacity());
+        for (size_t index = base; k < count; ++k, ++index) {
+            handles[index].slot = first + static_cast<std::uint32_t>(k);
+            out[k] = NPCHandle::make(static_cast<std::uint32_t>(index), handles[index].generation);
+        }
+    }
+
+    // the handle goes stale; its entry may be handed out again
+    void releaseHandle(NPCHandle h) noexcept {
+        HandleEntry &e = handles[h.index()];
+        if (++e.generation == 0) e.generation = 1;
+        freeHandles.push_back(h.index());
+    }
+
+    // the caller has checked the bounds and that the name is free
+    void push(std::unique_ptr<NPCBase> npc) {
+        const bool alive = npc->alive();
+        const std::uint32_t id = names.add(npc->name());
+        const auto next = static_cast<std::uint32_t>(cols.size());
+        const std::uint32_t slot = cols.push(npc->x(), npc->y(), npc->kind(), id, acquireHandle(next));
+        cols.alive[slot] = alive ? 1 : 0;
+        if (id >= slotOfName.size()) slotOfName.resize(id + 1);
+        slotOfName[id] = slot;
+        npc->bind(&cols, slot);
+        npcs.push_back(std::move(npc));
+        ++live;
+        combat.gridValid = false;
+    }
+
+    size_t slotOf(const std::string &name) const noexcept {
+        const std::uint32_t id = names.find(name);
+        return id == NameTable::npos ? npcs.size() : slotOfName[id];
+    }
+
+    void reserve(size_t n) {
+        npcs.reserve(n);
+        cols.reserve(n);
+        names.reserve(n);
+        handles.reserve(n);
+    }
+
+    void reset() noexcept {
+        // handles of the old roster must not resolve to the new one
+        for (size_t i = 0; i < cols.size(); ++i) releaseHandle(cols.handle[i]);
+        npcs.clear();
+        cols.clear();
+        names.clear();
+        slotOfName.clear();
+        live = 0;
+        tombs = 0;
+        cleanRange = std::numeric_limits<double>::infinity();
+        combat.gridValid = false;
+    }
+
+    void bindSlot(size_t slot) noexcept {
+        if (npcs[slot]) npcs[slot]->bind(&cols, static_cast<std::uint32_t>(slot));
+        slotOfName[cols.nameId[slot]] = static_cast<std::uint32_t>(slot);
+        handles[cols.handle[slot].index()].slot = static_cast<std::uint32_t>(slot);
+    }
+
+    // turns a slot into a tombstone; its name may be taken again right away
+    void bury(size_t slot) noexcept {
+        cols.alive[slot] = 0;
+        cols.dirty[slot] = 0;
+        cols.tomb[slot] = 1;
+        names.unindex(cols.nameId[slot]);
+        --live;
+        ++tombs;
+    }
+
+    // drops tombstones, keeping the other NPCs' relative order
+    void compact() {
+        if (tombs == 0) return;
+        size_t out = 0;
+        for (size_t i = 0; i < npcs.size(); ++i) {
+            if (cols.tomb[i]) {
+                names.release(cols.nameId[i]);
+                releaseHandle(cols.handle[i]);
+                continue;
+            }
+            if (out != i) {
+                cols.moveSlot(i, out);
+                npcs[out] = std::move(npcs[i]);
+                bindSlot(out);
+            }
+            ++out;
+        }
+        npcs.resize(out);
+        cols.resize(out);
+        tombs = 0;
+        combat.gridValid = false;   // slots were renumbered
+    }
+
+    void maybeCompact() {
+        if (static_cast<double>(tombs) > compactFraction * static_cast<double>(cols.size())) compact();
+    }
+};
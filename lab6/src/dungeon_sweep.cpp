@@ -0,0 +1,168 @@
+#include "dungeon.hpp"
+#include "dungeon_impl.hpp"
+#include "distance_kernel.hpp"
+#include "species.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+// killRank fits 32 bits: there are fewer than 2^24 slots, one per handle
+static constexpr std::uint32_t kNoRank = std::numeric_limits<std::uint32_t>::max();
+
+// index of the first entry of the ascending `r2s` that is >= d2, r2s.size()
+// if none; the steps depend only on the size, so it compiles to conditional
+// moves and random distances cost no mispredictions
+static size_t firstReaching(const std::vector<double> &r2s, double d2) noexcept {
+    size_t first = 0, len = r2s.size();
+    while (len > 1) {
+        const size_t half = len / 2;
+        first += r2s[first + half - 1] < d2 ? half : 0;
+        len -= half;
+    }
+    return first + (r2s[first] < d2);
+}
+
+std::vector<CombatSweep> Dungeon::sweepCombat(std::span<const double> ranges) const {
+    const NPCColumns &cols = pimpl_->cols;
+    const size_t n = cols.size();
+
+    std::vector<CombatSweep> result(ranges.size());
+    std::vector<size_t> order;                      // ranges runCombat would act on
+    for (size_t k = 0; k < ranges.size(); ++k) {
+        result[k].range = ranges[k];
+        if (ranges[k] >= 0.0) order.push_back(k);
+    }
+    if (n < 2 || order.empty()) return result;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ranges[a] < ranges[b]; });
+    std::vector<double> r2s(order.size());          // ascending, like order
+    for (size_t s = 0; s < order.size(); ++s) r2s[s] = ranges[order[s]] * ranges[order[s]];
+    const double maxRange = ranges[order.back()];
+
+    // A copy's round is a full scan over the NPCs alive now, so the pairs
+    // are met as in a full round at the largest range, each from one side.
+    // Its squared distance is the one the distance test computed, so a
+    // range reaches the pair exactly when runCombat at that range would.
+    const double *xs = cols.x.data();
+    const double *ys = cols.y.data();
+    const NPCKind *kinds = cols.kind.data();
+    const std::uint8_t *alive = cols.alive.data();
+    std::array<std::vector<std::uint32_t>, kNPCKindCount> members;
+    for (size_t i = 0; i < n; ++i) {
+        const auto k = static_cast<size_t>(kinds[i]);
+        if (alive[i] && k < kNPCKindCount) members[k].push_back(static_cast<std::uint32_t>(i));
+    }
+    std::array<SpatialGrid, kNPCKindCount> grids;
+    for (size_t k = 0; k < kNPCKindCount; ++k) grids[k].build(cols.x, cols.y, members[k], maxRange, kWorldSize);
+    bool scans[kNPCKindCount][kNPCKindCount] = {};
+    for (size_t a = 0; a < kNPCKindCount; ++a) {
+        for (size_t b = 0; b < kNPCKindCount; ++b) {
+            if (!canFight(static_cast<NPCKind>(a), static_cast<NPCKind>(b))) continue;
+            const size_t na = grids[a].size(), nb = grids[b].size();
+            scans[a][b] = a == b || na < nb || (na == nb && a < b);
+        }
+    }
+
+    // the pool runs one parallelFor at a time; a sweep that finds it busy
+    // with another sweep runs on its own thread instead
+    std::unique_lock<std::mutex> poolLock(pimpl_->sweepPoolMutex, std::try_to_lock);
+    ThreadPool *pool = poolLock.owns_lock() ? pimpl_->threads.get() : nullptr;
+    const size_t workers = pool ? pool->size() : 1;
+    std::vector<std::vector<std::uint64_t>> masks(workers, std::vector<std::uint64_t>((n + 63) / 64));
+    const double maxR2 = maxRange * maxRange;
+
+    // firstRank[v * K + s]: lowest killer rank among the kill relations of
+    // victim v that the s-th smallest range reaches and no smaller one does
+    const size_t K = order.size();
+    std::vector<std::uint32_t> firstRank(n * K, kNoRank);
+    auto recordKill = [&](size_t killer, size_t victim, double d2) {
+        const size_t s = firstReaching(r2s, d2);
+        const auto rank = static_cast<std::uint32_t>(killRank(killer, victim, n));
+        std::atomic_ref<std::uint32_t> best(firstRank[victim * K + s]);
+        std::uint32_t cur = best.load(std::memory_order_relaxed);
+        while (rank < cur && !best.compare_exchange_weak(cur, rank, std::memory_order_relaxed)) {}
+    };
+    auto scanRows = [&](size_t rowBegin, size_t rowEnd, unsigned worker) {
+        auto &mask = masks[worker];
+        for (size_t i = rowBegin; i < rowEnd; ++i) {
+            if (!alive[i]) continue;
+            const auto own = static_cast<size_t>(kinds[i]);
+            if (own >= kNPCKindCount) continue;
+            for (size_t other = 0; other < kNPCKindCount; ++other) {
+                if (!scans[own][other]) continue;
+                const bool lowerRowOnly = own == other;
+                const SpatialGrid &grid = grids[other];
+                const std::uint32_t *cellItems = grid.items();
+                const double *gx = grid.xs(), *gy = grid.ys();
+                grid.forEachNearRun(xs[i], ys[i], [&](std::uint32_t b, std::uint32_t e) {
+                    inRangeMask(xs[i], ys[i], gx + b, gy + b, e - b, maxR2, mask.data());
+                    for (size_t w = 0; w < (e - b + 63) / 64; ++w) {
+                        for (std::uint64_t bits = mask[w]; bits; bits &= bits - 1) {
+                            const size_t at = b + w * 64 + std::countr_zero(bits);
+                            const size_t j = cellItems[at];
+                            if (j == i || (lowerRowOnly && j < i)) continue;
+                            const double dx = xs[i] - gx[at], dy = ys[i] - gy[at];
+                            const double d2 = dx*dx + dy*dy;
+                            if (kills(kinds[i], kinds[j])) recordKill(i, j, d2);
+                            if (kills(kinds[j], kinds[i])) recordKill(j, i, d2);
+                        }
+                    }
+                });
+            }
+        }
+    };
+    if (pool) pool->parallelFor(n, kCombatGrain, scanRows);
+    else scanRows(0, n, 0);
+
+    // a victim dies at every range from its nearest relation's on; its
+    // first killer at a range is the lowest rank reached up to there
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> dead(K);   // (victim, rank)
+    for (size_t v = 0; v < n; ++v) {
+        std::uint32_t best = kNoRank;
+        for (size_t s = 0; s < K; ++s) {
+            best = std::min(best, firstRank[v * K + s]);
+            if (best != kNoRank) dead[s].push_back({static_cast<std::uint32_t>(v), best});
+        }
+    }
+
+    // Each range's events in runCombat's order: by the lower row of the
+    // pair first (a counting sort, the lists are in victim order), then by
+    // the upper row and victim within the few events sharing a lower row.
+    auto emit = [&](size_t s, std::vector<std::uint32_t> &start) {
+        const auto &list = dead[s];
+        auto lo = [&](const std::pair<std::uint32_t, std::uint32_t> &d) {
+            return std::min<size_t>(killerFromRank(d.second, n), d.first);
+        };
+        start.assign(n + 1, 0);
+        for (const auto &d : list) ++start[lo(d) + 1];
+        for (size_t r = 0; r < n; ++r) start[r + 1] += start[r];
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> sorted(list.size());
+        for (const auto &d : list) sorted[start[lo(d)]++] = d;
+        auto key = [&](const std::pair<std::uint32_t, std::uint32_t> &d) {
+            return eventKey(killerFromRank(d.second, n), d.first);
+        };
+        for (size_t b = 0; b < sorted.size();) {
+            size_t e = b + 1;
+            while (e < sorted.size() && lo(sorted[e]) == lo(sorted[b])) ++e;
+            if (e - b > 1)
+                std::sort(sorted.begin() + b, sorted.begin() + e, [&](const auto &x, const auto &y) { return key(x) < key(y); });
+            b = e;
+        }
+        std::vector<DeathEvent> &events = result[order[s]].events;
+        events.reserve(sorted.size());
+        for (const auto &[v, rank] : sorted)
+            events.push_back({cols.handle[killerFromRank(rank, n)], cols.handle[v], xs[v], ys[v]});
+    };
+    if (pool) {
+        std::vector<std::vector<std::uint32_t>> starts(workers);
+        pool->parallelFor(K, 1, [&](size_t b, size_t e, unsigned w) {
+            for (size_t s = b; s < e; ++s) emit(s, starts[w]);
+        });
+    } else {
+        std::vector<std::uint32_t> start;
+        for (size_t s = 0; s < K; ++s) emit(s, start);
+    }
+    return result;
+}
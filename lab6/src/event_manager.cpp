@@ -1,11 +1,179 @@
 #include "observer.hpp"
+#include <algorithm>
+#include <string>
+
+namespace {
+
+// stands in while no name source is set
+struct NoNames : INameSource {
+    std::string_view nameOf(NPCHandle) const noexcept override { return {}; }
+};
+const NoNames kNoNames;
+
+} // namespace
+
+// Copy of the names a queued batch refers to, taken when it is published:
+// by the time the dispatcher delivers it the NPCs may be gone.
+struct EventManager::FrozenNames : INameSource {
+    struct Entry {
+        std::uint32_t handle;
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+    std::string text;
+    std::vector<Entry> entries;   // sorted by handle
+
+    FrozenNames(std::span<const DeathEvent> evs, const INameSource &names) {
+        entries.reserve(evs.size() * 2);
+        for (const DeathEvent &ev : evs) {
+            for (NPCHandle h : {ev.killer, ev.victim}) {
+                const std::string_view name = names.nameOf(h);
+                entries.push_back({h.value, static_cast<std::uint32_t>(text.size()),
+                                   static_cast<std::uint32_t>(name.size())});
+                text.append(name);
+            }
+        }
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Entry &a, const Entry &b) { return a.handle < b.handle; });
+    }
+
+    std::string_view nameOf(NPCHandle h) const noexcept override {
+        auto it = std::lower_bound(entries.begin(), entries.end(), h.value,
+                                   [](const Entry &e, std::uint32_t v) { return e.handle < v; });
+        if (it == entries.end() || it->handle != h.value) return {};
+        return std::string_view(text).substr(it->offset, it->length);
+    }
+};
+
+// Vyukov's intrusive MPSC queue: producers link nodes in with one exchange,
+// the single consumer (the dispatcher thread) unlinks them without locks.
+struct EventManager::AsyncQueue {
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::vector<DeathEvent> batch;
+        std::unique_ptr<FrozenNames> names;
+    };
+
+    Node stub;
+    std::atomic<Node*> head{&stub};   // producers push here
+    Node *tail = &stub;               // consumer pops here
+    std::atomic<std::uint64_t> published{0};
+    std::atomic<std::uint64_t> delivered{0};
+    std::atomic<bool> stop{false};
+    std::thread dispatcher;
+
+    ~AsyncQueue() {
+        while (pop()) {}
+        if (tail != &stub) delete tail;
+    }
+
+    void push(std::span<const DeathEvent> batch, const INameSource &names) {
+        Node *n = new Node;
+        n->batch.assign(batch.begin(), batch.end());
+        n->names = std::make_unique<FrozenNames>(batch, names);
+        Node *prev = head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+        published.fetch_add(1, std::memory_order_release);
+        published.notify_one();
+    }
+
+    // next node whose batch is ready, or nullptr; the returned node is no
+    // longer referenced by the queue once the following pop happens
+    Node* pop() {
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (!next) return nullptr;
+        if (tail != &stub) delete tail;
+        tail = next;
+        return next;
+    }
+};
+
+EventManager::EventManager() : observers_(std::make_shared<const ObserverList>()) {}
+
+EventManager::~EventManager() {
+    setAsync(false);
+}
 
 void EventManager::subscribe(std::shared_ptr<IObserver> obs) {
-    if (obs) observers_.push_back(std::move(obs));
+    if (!obs) return;
+    std::lock_guard<std::mutex> lk(observersMutex_);
+    auto next = std::make_shared<ObserverList>(*observers_);
+    next->push_back(std::move(obs));
+    observers_ = std::move(next);
+}
+
+std::shared_ptr<const EventManager::ObserverList> EventManager::observers() const {
+    std::lock_guard<std::mutex> lk(observersMutex_);
+    return observers_;
+}
+
+void EventManager::setNameSource(const INameSource *names) noexcept {
+    names_ = names;
 }
 
+const INameSource& EventManager::names() const noexcept {
+    return names_ ? *names_ : kNoNames;
+}
+
+// observers are called on a snapshot of the list with the lock released, so
+// one may subscribe from inside its callback (the newcomer gets the next
+// event) and a slow one never blocks subscribe
 void EventManager::notify(const DeathEvent &ev) const {
-    for (auto &o : observers_) {
-        if (o) o->onDeath(ev);
+    const auto list = observers();
+    for (auto &o : *list) {
+        if (o) o->onDeath(ev, names());
+    }
+}
+
+void EventManager::deliver(std::span<const DeathEvent> evs, const INameSource &names) {
+    const auto list = observers();
+    for (auto &o : *list) {
+        if (o) o->onDeaths(evs, names);
+    }
+}
+
+void EventManager::publish(std::span<const DeathEvent> batch) {
+    if (batch.empty()) return;
+    if (async_) async_->push(batch, names());
+    else deliver(batch, names());
+}
+
+void EventManager::setAsync(bool on) {
+    if (on == async()) return;
+    if (!on) {
+        flush();
+        async_->stop.store(true, std::memory_order_release);
+        async_->published.fetch_add(1, std::memory_order_release);   // wake the dispatcher
+        async_->published.notify_one();
+        async_->dispatcher.join();
+        async_.reset();
+        return;
+    }
+    async_ = std::make_unique<AsyncQueue>();
+    AsyncQueue *q = async_.get();
+    q->dispatcher = std::thread([this, q] {
+        std::uint64_t seen = 0;
+        while (true) {
+            while (AsyncQueue::Node *n = q->pop()) {
+                // a throwing observer must not take the dispatcher down
+                try { deliver(n->batch, *n->names); } catch (...) {}
+                n->batch = {};
+                n->names.reset();
+                q->delivered.fetch_add(1, std::memory_order_release);
+                q->delivered.notify_all();
+            }
+            if (q->stop.load(std::memory_order_acquire)) return;
+            q->published.wait(seen, std::memory_order_acquire);
+            seen = q->published.load(std::memory_order_acquire);
+        }
+    });
+}
+
+void EventManager::flush() {
+    if (!async_) return;
+    const std::uint64_t target = async_->published.load(std::memory_order_acquire);
+    for (std::uint64_t d = async_->delivered.load(std::memory_order_acquire); d < target;
+         d = async_->delivered.load(std::memory_order_acquire)) {
+        async_->delivered.wait(d, std::memory_order_acquire);
     }
 }
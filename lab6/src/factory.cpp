@@ -1,19 +1,124 @@
 #include "factory.hpp"
 #include "npc.hpp"
-#include "npc_types.hpp"
-#include <sstream>
-
-std::unique_ptr<NPCBase> NPCFactory::create(const std::string &type, const std::string &name, double x, double y) {
-    if (type == "Orc") return std::make_unique<Orc>(name, x, y);
-    if (type == "Bear") return std::make_unique<Bear>(name, x, y);
-    if (type == "Squirrel") return std::make_unique<Squirrel>(name, x, y);
-    return nullptr;
-}
-
-std::unique_ptr<NPCBase> NPCFactory::createFromLine(const std::string &line) {
-    std::istringstream iss(line);
-    std::string type, name;
-    double x, y;
-    if (!(iss >> type >> name >> x >> y)) return nullptr;
-    return create(type, name, x, y);
+#include "npc_variant.hpp"
+#include "species.hpp"
+#include <algorithm>
+#include <charconv>
+
+template <class Species>
+static std::unique_ptr<NPCBase> make(std::string_view name, double x, double y, NPCPool *pool) {
+    return std::unique_ptr<NPCBase>(new (pool) Species(std::string(name), x, y, pool));
+}
+
+// NPCKind -> constructor of that species
+static constexpr auto kMake = perSpecies(SpeciesRegistry{}, [](auto s) { return &make<typename decltype(s)::type>; });
+
+template <class Species>
+static NPCVariant makeValue(std::string_view name, double x, double y, NPCPool *pool) {
+    return NPCVariant(std::in_place_type<Species>, std::string(name), x, y, pool);
+}
+
+static constexpr auto kMakeValue = perSpecies(SpeciesRegistry{}, [](auto s) { return &makeValue<typename decltype(s)::type>; });
+
+std::unique_ptr<NPCBase> NPCFactory::create(std::string_view type, std::string_view name, double x, double y,
+                                            NPCPool *pool) {
+    return create(kindFromName(type), name, x, y, pool);
+}
+
+std::unique_ptr<NPCBase> NPCFactory::create(NPCKind kind, std::string_view name, double x, double y,
+                                            NPCPool *pool) {
+    const auto k = static_cast<std::size_t>(kind);
+    return k < kMake.size() ? kMake[k](name, x, y, pool) : nullptr;
+}
+
+std::optional<NPCVariant> makeNPCVariant(NPCKind kind, std::string_view name, double x, double y,
+                                         NPCPool *pool) {
+    const auto k = static_cast<std::size_t>(kind);
+    if (k >= kMakeValue.size()) return std::nullopt;
+    return kMakeValue[k](name, x, y, pool);
+}
+
+static bool isSpace(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+// next whitespace-separated token starting at pos; empty at end of line
+static std::string_view nextToken(std::string_view s, std::size_t &pos) noexcept {
+    while (pos < s.size() && isSpace(s[pos])) ++pos;
+    const std::size_t b = pos;
+    while (pos < s.size() && !isSpace(s[pos])) ++pos;
+    return s.substr(b, pos - b);
+}
+
+// For a number from_chars found out of range: true if it is too small
+// rather than too large, from the decimal exponent of its first
+// significant digit.
+static bool underflows(const char *b, const char *e) noexcept {
+    if (*b == '-') ++b;
+    long long lead = 0;       // integer digits from the first nonzero one on
+    long long zeros = 0;      // zeros after the point, while the integer part is zero
+    bool dot = false, nonzero = false;
+    for (; b != e && *b != 'e' && *b != 'E'; ++b) {
+        if (*b == '.') { dot = true; continue; }
+        if (!dot) {
+            nonzero = nonzero || *b != '0';
+            lead += nonzero;
+        } else if (!nonzero) {
+            if (*b == '0') ++zeros;
+            else nonzero = true;
+        }
+    }
+    long long exp = 0;
+    if (b != e) {
+        const char *p = b + 1;
+        const bool negative = *p == '-';
+        if (*p == '+' || *p == '-') ++p;
+        for (; p != e; ++p) exp = std::min<long long>(exp * 10 + (*p - '0'), 1'000'000);
+        if (negative) exp = -exp;
+    }
+    return (lead > 0 ? lead - 1 : -(zeros + 1)) + exp < 0;
+}
+
+// Locale-independent double read from the start of `s`, the way operator>>
+// reads it: one optional sign ('+' or '-'), no inf/nan spellings, a number
+// too small for a double reads as zero and one too large fails, and an 'e'
+// with no exponent digits after it fails the whole number. Returns the end
+// of the number, nullptr on failure.
+static const char* parseDouble(std::string_view s, double &out) noexcept {
+    const char *b = s.data(), *e = s.data() + s.size();
+    const char *d = b != e && (*b == '+' || *b == '-') ? b + 1 : b;
+    if (d == e || !(*d == '.' || (*d >= '0' && *d <= '9'))) return nullptr;
+    if (*b == '+') ++b;   // from_chars takes only '-'
+    auto res = std::from_chars(b, e, out);
+    if (res.ec == std::errc::result_out_of_range && underflows(b, res.ptr)) {
+        out = *b == '-' ? -0.0 : 0.0;
+        res.ec = std::errc();
+    }
+    if (res.ec != std::errc()) return nullptr;
+    if (res.ptr != e && (*res.ptr == 'e' || *res.ptr == 'E') &&
+        std::find_if(b, res.ptr, [](char c) { return c == 'e' || c == 'E'; }) == res.ptr)
+        return nullptr;
+    return res.ptr;
+}
+
+bool NPCFactory::parseLine(std::string_view line, NPCRecord &out) noexcept {
+    std::size_t pos = 0;
+    out.type = nextToken(line, pos);
+    out.name = nextToken(line, pos);
+    if (out.name.empty()) return false;
+    // like `>> x >> y`: y starts right where x stopped ("10+5" is x = 10,
+    // y = 5) and anything after y is ignored
+    auto skipSpace = [&] { while (pos < line.size() && isSpace(line[pos])) ++pos; };
+    skipSpace();
+    const char *endX = parseDouble(line.substr(pos), out.x);
+    if (!endX) return false;
+    pos = static_cast<std::size_t>(endX - line.data());
+    skipSpace();
+    return parseDouble(line.substr(pos), out.y) != nullptr;
+}
+
+std::unique_ptr<NPCBase> NPCFactory::createFromLine(std::string_view line, NPCPool *pool) {
+    NPCRecord rec;
+    if (!parseLine(line, rec)) return nullptr;
+    return create(rec.type, rec.name, rec.x, rec.y, pool);
 }
@@ -0,0 +1,118 @@
+#include "file_logger.hpp"
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+FileLogger::FileLogger(std::string path, FileLoggerOptions opts)
+    : path_(std::move(path)), opts_(opts), lastFlush_(std::chrono::steady_clock::now()) {
+    buf_.reserve(opts_.bufferBytes);
+    std::lock_guard<std::mutex> lk(m_);
+    openLocked();
+}
+
+FileLogger::~FileLogger() {
+    std::lock_guard<std::mutex> lk(m_);
+    flushLocked();
+    if (file_) std::fclose(file_);
+}
+
+bool FileLogger::openLocked() {
+    file_ = std::fopen(path_.c_str(), "ab");
+    if (!file_) return false;
+    // the logger does its own buffering
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    std::fseek(file_, 0, SEEK_END);
+    const long size = std::ftell(file_);
+    fileBytes_ = size > 0 ? static_cast<std::uint64_t>(size) : 0;
+    return true;
+}
+
+void FileLogger::onDeath(const DeathEvent &ev, const INameSource &names) {
+    std::lock_guard<std::mutex> lk(m_);
+    append(ev, names);
+    maybeFlush();
+}
+
+void FileLogger::onDeaths(std::span<const DeathEvent> evs, const INameSource &names) {
+    std::lock_guard<std::mutex> lk(m_);
+    for (auto &ev : evs) append(ev, names);
+    if (opts_.flushEachBatch) flushLocked();
+    else maybeFlush();
+}
+
+void FileLogger::flush() {
+    std::lock_guard<std::mutex> lk(m_);
+    flushLocked();
+}
+
+void FileLogger::append(const DeathEvent &ev, const INameSource &names) {
+    // same text and number format as the old per-event logger (%g == ostream default)
+    const std::string_view killer = names.nameOf(ev.killer), victim = names.nameOf(ev.victim);
+    char coords[64];
+    const int len = std::snprintf(coords, sizeof coords, " в точке (%g,%g)\n", ev.x, ev.y);
+    const std::size_t need = killer.size() + victim.size() + sizeof(" убил ") - 1 + static_cast<std::size_t>(len);
+    if (buf_.size() + need > opts_.bufferBytes) flushLocked();
+    if (buf_.size() + need > opts_.bufferBytes && !buf_.empty()) {
+        ++lostLines_;   // the file takes nothing; keep the lines already buffered
+        return;
+    }
+    buf_.insert(buf_.end(), killer.begin(), killer.end());
+    const char *mid = " убил ";
+    buf_.insert(buf_.end(), mid, mid + std::strlen(mid));
+    buf_.insert(buf_.end(), victim.begin(), victim.end());
+    buf_.insert(buf_.end(), coords, coords + len);
+}
+
+void FileLogger::maybeFlush() {
+    if (opts_.flushThreshold && buf_.size() >= opts_.flushThreshold) {
+        flushLocked();
+        return;
+    }
+    if (opts_.flushInterval.count() > 0 &&
+        std::chrono::steady_clock::now() - lastFlush_ >= opts_.flushInterval) {
+        flushLocked();
+    }
+}
+
+void FileLogger::flushLocked() {
+    lastFlush_ = std::chrono::steady_clock::now();
+    if (buf_.empty() || !file_) return;
+    // a tail left by a short write may start mid-line; it goes to the
+    // current file, so that lines are never split across files
+    if (!midLine_ && opts_.rotateBytes && fileBytes_ > 0 && fileBytes_ + buf_.size() > opts_.rotateBytes)
+        rotateLocked();
+    if (!file_) return;
+    const std::size_t written = std::fwrite(buf_.data(), 1, buf_.size(), file_);
+    fileBytes_ += written;
+    if (written < buf_.size()) {
+        // keep what was not written for the next flush
+        std::clearerr(file_);
+        failed_ = true;
+        if (written > 0) midLine_ = buf_[written - 1] != '\n';
+        buf_.erase(buf_.begin(), buf_.begin() + static_cast<std::ptrdiff_t>(written));
+        return;
+    }
+    buf_.clear();
+    failed_ = false;
+    midLine_ = false;
+#if defined(__unix__) || defined(__APPLE__)
+    if (opts_.syncOnFlush) ::fsync(fileno(file_));
+#endif
+}
+
+void FileLogger::rotateLocked() {
+    std::fclose(file_);
+    file_ = nullptr;
+    if (opts_.keepFiles == 0) {
+        std::remove(path_.c_str());
+    } else {
+        // log.txt.(N-1) -> log.txt.N, ..., log.txt -> log.txt.1
+        std::remove((path_ + "." + std::to_string(opts_.keepFiles)).c_str());
+        for (unsigned k = opts_.keepFiles; k > 1; --k)
+            std::rename((path_ + "." + std::to_string(k - 1)).c_str(), (path_ + "." + std::to_string(k)).c_str());
+        std::rename(path_.c_str(), (path_ + ".1").c_str());
+    }
+    openLocked();
+}
@@ -1,41 +1,44 @@
+#include <algorithm>
 #include <iostream>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <sstream>
+#include <stdexcept>
 #include <iomanip>
-#include <fstream>
 #include <chrono>
 #include <ctime>
-#include <algorithm>
-#include <cctype>
 #include <vector>
 
 #include "dungeon.hpp"
 #include "factory.hpp"
 #include "observer.hpp"
+#include "file_logger.hpp"
 #include "npc.hpp"
+#include "species.hpp"
+#include "world_generator.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
 
 
 struct ConsoleLogger : public IObserver {
-    void onDeath(const DeathEvent &ev) override {
-        std::cout << "[LOG] " << ev.killer << " убил " << ev.victim << " в точке (" << ev.x << "," << ev.y << ")\n";
+    void onDeath(const DeathEvent &ev, const INameSource &names) override {
+        std::cout << "[LOG] " << names.nameOf(ev.killer) << " убил " << names.nameOf(ev.victim) << " в точке (" << ev.x << "," << ev.y << ")\n";
     }
 };
 
 
-struct FileLogger : public IObserver {
-    explicit FileLogger(std::string filename = "log.txt") : fn(std::move(filename)) {}
-    void onDeath(const DeathEvent &ev) override {
-        std::ofstream f(fn, std::ios::app);
-        if (!f) {
-            return;
-        }
-
-        f << ev.killer << " убил " << ev.victim << " в точке (" << ev.x << "," << ev.y << ")\n";
+// "Orc|Bear|Squirrel"
+static std::string species_list() {
+    std::string s;
+    for (std::string_view name : kKindNames) {
+        if (!s.empty()) s += '|';
+        s += name;
     }
-private:
-    std::string fn;
-};
+    return s;
+}
 
 static void print_help() {
     std::cout <<
@@ -47,10 +50,83 @@ static void print_help() {
     "  save <имя файла>             - сохранение всех NPC в файл\n"
     "  load <имя файла>             - загрузка NPC из файла (все расставленные юниты будут удалены)\n"
     "  combat <дальность>           - запуск боя с указанной дальностью атаки для всех NPC (double)\n"
+    "  sweep <дальность> [...]      - сколько NPC погибло бы в бою при каждой дальности (NPC не гибнут)\n"
+    "  generate <n> <uniform|clusters> [seed=S] [clusters=K] [spread=D] [ratio=O:B:S] [prefix=P] [out=файл]\n"
+    "                               - сгенерировать n NPC (в подземелье или, с out=, в файл)\n"
+    "  stats [reset|on|off]         - статистика боёв: пары, убийства и время фаз (сбор по умолчанию выключен)\n"
     "  clear                        - удалить всех NPC\n"
     "  exit                         - закрыть\n";
 }
 
+static void print_usage() {
+    std::cout <<
+    "Использование: lab6_app [флаги]\n"
+    "  --script <файл>   - выполнить команды из файла без приглашений и справки\n"
+    "  --batch           - читать команды из stdin без приглашений (по умолчанию, если stdin не терминал)\n"
+    "  --quiet           - не выводить сообщения команд и журнал смертей в консоль\n"
+    "  --no-list         - не выводить список NPC после combat\n"
+    "  --stats           - собирать статистику боёв с самого начала (иначе только после 'stats on')\n"
+    "В пакетном режиме время каждой команды выводится в stderr, а код возврата\n"
+    "равен 1, если хотя бы одна команда завершилась ошибкой.\n";
+}
+
+static void print_stats(const CombatStats &st, bool enabled) {
+    auto ms = [](std::uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+    std::cout << "--- Статистика боёв (раундов: " << st.rounds << (enabled ? "" : ", сбор выключен") << ") ---\n"
+              << "  пар проверено:    " << st.pairsExamined << "\n"
+              << "  пар в радиусе:    " << st.pairsInRange << "\n"
+              << "  убийств найдено:  " << st.kills << "\n"
+              << "  событий:          " << st.events << "\n"
+              << "  удалено NPC:      " << st.removed << "\n"
+              << std::fixed << std::setprecision(3)
+              << "  время, мс: snapshot " << ms(st.snapshotNs) << ", scan " << ms(st.scanNs)
+              << ", apply " << ms(st.applyNs) << ", notify " << ms(st.notifyNs)
+              << ", erase " << ms(st.eraseNs) << "\n" << std::defaultfloat;
+}
+
+// upper bound for generate's n and clusters=: as many NPCs as a dungeon can hold
+static constexpr long long kMaxGenerated = static_cast<long long>(NPCHandle::kMaxIndex) + 1;
+
+// a count in [1, kMaxGenerated]; read as signed, so "-1" is rejected
+// instead of wrapping around to SIZE_MAX
+static bool parse_count(std::istream &in, std::size_t &out) {
+    long long v = 0;
+    if (!(in >> v) || v <= 0 || v > kMaxGenerated) return false;
+    out = static_cast<std::size_t>(v);
+    return true;
+}
+
+// "key=value" options of the generate command; false on an unknown key or bad value
+static bool parse_world_option(const std::string &opt, WorldSpec &spec, std::string &out_file) {
+    const auto eq = opt.find('=');
+    if (eq == std::string::npos) return false;
+    const std::string key = opt.substr(0, eq), value = opt.substr(eq + 1);
+    std::istringstream v(value);
+    if (key == "seed") return static_cast<bool>(v >> spec.seed);
+    if (key == "clusters") return parse_count(v, spec.clusters);
+    if (key == "spread") return static_cast<bool>(v >> spec.spread);
+    if (key == "prefix") { spec.namePrefix = value; return !value.empty(); }
+    if (key == "out") { out_file = value; return !value.empty(); }
+    if (key == "ratio") {
+        // one share per kind in NPCKind order, separated by ':'
+        for (std::size_t k = 0; k < kNPCKindCount; ++k) {
+            char sep = ':';
+            if (k > 0 && !(v >> sep)) return false;
+            if (sep != ':' || !(v >> spec.ratio[k])) return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+static bool stdin_is_terminal() {
+#if defined(__unix__) || defined(__APPLE__)
+    return isatty(STDIN_FILENO) != 0;
+#else
+    return true;
+#endif
+}
+
 static std::vector<std::string> split_ws(const std::string &s) {
     std::istringstream iss(s);
     std::vector<std::string> t;
@@ -59,16 +135,46 @@ static std::vector<std::string> split_ws(const std::string &s) {
     return t;
 }
 
-int main() {
+int main(int argc, char **argv) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
+    std::string script;
+    bool batch = !stdin_is_terminal();
+    bool quiet = false;
+    bool list_after_combat = true;
+    bool collect_stats = false;   // off by default: the phase timers read the clock every round
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        if (arg == "--script" && a + 1 < argc) { script = argv[++a]; batch = true; }
+        else if (arg == "--batch") batch = true;
+        else if (arg == "--quiet") quiet = true;
+        else if (arg == "--no-list") list_after_combat = false;
+        else if (arg == "--stats") collect_stats = true;
+        else if (arg == "--help" || arg == "-h") { print_usage(); return 0; }
+        else { std::cerr << "Неизвестный флаг '" << arg << "'\n"; print_usage(); return 2; }
+    }
+
+    std::ifstream script_file;
+    if (!script.empty()) {
+        script_file.open(script);
+        if (!script_file) { std::cerr << "Не удалось открыть сценарий '" << script << "'\n"; return 2; }
+    }
+    std::istream &in = script.empty() ? std::cin : script_file;
+
+    // messages of commands; --quiet sends them nowhere
+    std::ostream null_out(nullptr);
+    std::ostream &out = quiet ? null_out : std::cout;
+
     Dungeon d;
-    d.events().subscribe(std::make_shared<ConsoleLogger>());
+    d.enableStats(collect_stats);
+    if (!quiet) d.events().subscribe(std::make_shared<ConsoleLogger>());
     d.events().subscribe(std::make_shared<FileLogger>("log.txt"));
 
-    std::cout << "Balagur Fate 3 — редактор подземелий\n";
-    print_help();
+    if (!batch) {
+        std::cout << "Balagur Fate 3 — редактор подземелий\n";
+        print_help();
+    }
 
     auto trim = [](std::string s) -> std::string {
         auto l = s.find_first_not_of(" \t\r\n");
@@ -76,16 +182,12 @@ int main() {
         auto r = s.find_last_not_of(" \t\r\n");
         return s.substr(l, r - l + 1);
     };
-    auto to_lower = [](std::string s) {
-        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        return s;
-    };
 
     auto read_line = [&](const std::string &prompt)->std::string {
         std::string s;
         while (true) {
             std::cout << prompt;
-            if (!std::getline(std::cin, s)) return std::string(); // EOF signal -> cancel
+            if (!std::getline(in, s)) return std::string(); // EOF signal -> cancel
             s = trim(s);
             if (s.empty()) {
                 std::cout << "Пустой ввод — попытайтесь ещё раз или введите 'cancel'/'q' для отмены\n";
@@ -115,16 +217,38 @@ int main() {
         }
     };
 
+    // in batch mode every command is timed and reported to stderr
+    bool failed = false;
+    bool command_failed = false;
+    auto fail = [&](const std::string &msg) {
+        (batch ? std::cerr : std::cout) << msg;
+        command_failed = true;
+    };
+    std::string current;
+    std::chrono::steady_clock::time_point started;
+    auto finish_command = [&]() {
+        if (!batch || current.empty()) return;
+        const std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - started;
+        std::cerr << "[time] " << current << ": " << std::fixed << std::setprecision(3) << took.count() << " ms"
+                  << (command_failed ? " (ошибка)" : "") << "\n" << std::defaultfloat;
+        failed = failed || command_failed;
+        current.clear();
+    };
+
     std::string line;
     while (true) {
-        std::cout << "> " << std::flush;
-        if (!std::getline(std::cin, line)) break;
+        finish_command();
+        if (!batch) std::cout << "> " << std::flush;
+        if (!std::getline(in, line)) break;
         line = trim(line);
-        if (line.empty()) continue;
+        if (line.empty() || line[0] == '#') continue;
 
         std::istringstream iss(line);
         std::string cmd;
         iss >> cmd;
+        current = line;
+        command_failed = false;
+        started = std::chrono::steady_clock::now();
         if (cmd == "help") {
             print_help();
 
@@ -144,29 +268,28 @@ int main() {
                 type = rest[0]; name = rest[1];
                 std::istringstream sx(rest[2]), sy(rest[3]);
                 if (!(sx >> x) || !(sy >> y) || x < 0 || x > 500 || y < 0 || y > 500) {
-                    std::cout << "Invalid inline parameters. Falling back to interactive mode.\n";
+                    if (!batch) out << "Invalid inline parameters. Falling back to interactive mode.\n";
                 } else {
-                    // normalize type
-                    std::string low = to_lower(type);
-                    if (low == "orc") type = "Orc";
-                    else if (low == "bear") type = "Bear";
-                    else if (low == "squirrel") type = "Squirrel";
-                    else { std::cout << "Unknown type in inline args. Falling back to interactive.\n"; }
-                    if (type == "Orc" || type == "Bear" || type == "Squirrel") {
-                        auto npc = NPCFactory::create(type, name, x, y);
+                    const NPCKind kind = kindFromNameIgnoreCase(type);
+                    if (kind == NPCKind::Unknown) { if (!batch) out << "Unknown type in inline args. Falling back to interactive.\n"; }
+                    else {
+                        type = kindName(kind);
+                        auto npc = NPCFactory::create(type, name, x, y, d.pool());
                         if (npc && d.addNPC(std::move(npc))) {
-                            std::cout << "Added " << type << " '" << name << "' at (" << x << "," << y << ")\n";
+                            out << "Added " << type << " '" << name << "' at (" << x << "," << y << ")\n";
                             done = true;
                         } else {
-                            std::cout << "Failed to add NPC (duplicate name or coords). Enter interactive mode.\n";
+                            if (!batch) out << "Failed to add NPC (duplicate name or coords). Enter interactive mode.\n";
                         }
                     }
                 }
             }
 
             if (done) continue;
+            // a script has nobody to answer the questions below
+            if (batch) { fail("Не удалось добавить NPC: " + line + "\n"); continue; }
 
-            std::string tline = read_line("Класс (Orc|Bear|Squirrel) (или 'cancel'/'q'): ");
+            std::string tline = read_line("Класс (" + species_list() + ") (или 'cancel'/'q'): ");
             if (tline.empty()) { std::cout << "Отмена добавления\n"; continue; }
 
             auto toks = split_ws(tline);
@@ -175,12 +298,10 @@ int main() {
                 std::istringstream sx(toks[2]), sy(toks[3]);
                 if (!(sx >> x) || !(sy >> y)) { std::cout << "Invalid numbers in single-line input. Switching to step mode.\n"; }
                 else {
-                    std::string low = to_lower(type);
-                    if (low == "orc") type = "Orc";
-                    else if (low == "bear") type = "Bear";
-                    else if (low == "squirrel") type = "Squirrel";
-                    else { std::cout << "Неизвестный класс NPC. Отмена добавления\n"; continue; }
-                    auto npc = NPCFactory::create(type, name, x, y);
+                    const NPCKind kind = kindFromNameIgnoreCase(type);
+                    if (kind == NPCKind::Unknown) { std::cout << "Неизвестный класс NPC. Отмена добавления\n"; continue; }
+                    type = kindName(kind);
+                    auto npc = NPCFactory::create(type, name, x, y, d.pool());
                     if (npc && d.addNPC(std::move(npc))) {
                         std::cout << "Добавлен " << type << " '" << name << "' в точке (" << x << "," << y << ")\n";
                         continue;
@@ -191,12 +312,9 @@ int main() {
                 }
             }
 
-            type = tline;
-            std::string low = to_lower(type);
-            if (low == "orc") type = "Orc";
-            else if (low == "bear") type = "Bear";
-            else if (low == "squirrel") type = "Squirrel";
-            else { std::cout << "Неизвестный класс NPC. Отмена добавления\n"; continue; }
+            const NPCKind kind = kindFromNameIgnoreCase(tline);
+            if (kind == NPCKind::Unknown) { std::cout << "Неизвестный класс NPC. Отмена добавления\n"; continue; }
+            type = kindName(kind);
 
             std::string name_in = read_line("Имя (уникальное) (или 'cancel'/'q'): ");
             if (name_in.empty()) { 
@@ -214,7 +332,7 @@ int main() {
                 continue; 
             }
 
-            auto npc = NPCFactory::create(type, name, x, y);
+            auto npc = NPCFactory::create(type, name, x, y, d.pool());
             if (!npc) { 
                 std::cout << "Ошибка создания. Добавление отменено\n"; 
                 continue; 
@@ -231,45 +349,89 @@ int main() {
         } else if (cmd == "save") {
             std::string fname;
             if (!(iss >> fname)) {
-                std::cout << "Использование: save <имя файла>\n";
+                fail("Использование: save <имя файла>\n");
                 continue;
             }
-            if (d.saveToFile(fname)) std::cout << "Сохранено в '" << fname << "'\n";
-            else std::cout << "Не удалось сохранить в файл '" << fname << "'\n";
+            if (d.saveToFile(fname)) out << "Сохранено в '" << fname << "'\n";
+            else fail("Не удалось сохранить в файл '" + fname + "'\n");
 
         } else if (cmd == "load") {
             std::string fname;
             if (!(iss >> fname)) {
-                std::cout << "Использование: load <имя файла>\n";
+                fail("Использование: load <имя файла>\n");
                 continue;
             }
-            if (d.loadFromFile(fname)) std::cout << "Загрузка из файла '" << fname << "'\n";
-            else std::cout << "Не удалось загрузить файл '" << fname << "'\n";
+            if (d.loadFromFile(fname)) out << "Загрузка из файла '" << fname << "'\n";
+            else fail("Не удалось загрузить файл '" + fname + "'\n");
 
         } else if (cmd == "combat") {
             double R;
             if (!(iss >> R)) {
-                std::cout << "Использование: combat <дальность>\n";
+                fail("Использование: combat <дальность>\n");
                 continue;
             }
-            if (R < 0.0) { std::cout << "Дальность атаки не может быть отрицательной\n"; continue; }
-            std::cout << "Запуск сражения с дальностью атаки = " << R << " ...\n";
+            if (R < 0.0) { fail("Дальность атаки не может быть отрицательной\n"); continue; }
+            out << "Запуск сражения с дальностью атаки = " << R << " ...\n";
             d.runCombat(R);
-            std::cout << "Сражение завершено\n";
-            d.printAll();
+            out << "Сражение завершено\n";
+            if (list_after_combat && !quiet) d.printAll();
+
+        } else if (cmd == "sweep") {
+            std::vector<double> ranges;
+            for (double R; iss >> R;) ranges.push_back(R);
+            if (ranges.empty() || !iss.eof()) {
+                fail("Использование: sweep <дальность> [<дальность> ...]\n");
+                continue;
+            }
+            if (std::any_of(ranges.begin(), ranges.end(), [](double R) { return R < 0.0; })) {
+                fail("Дальность атаки не может быть отрицательной\n");
+                continue;
+            }
+            for (const CombatSweep &r : d.sweepCombat(ranges))
+                out << "Дальность " << r.range << ": погибших " << r.events.size() << "\n";
+
+        } else if (cmd == "generate") {
+            WorldSpec spec;
+            std::string dist, opt, out_file;
+            if (!parse_count(iss, spec.count) || !(iss >> dist) || !parseWorldDistribution(dist, spec.distribution)) {
+                fail("Использование: generate <n> <uniform|clusters> [seed=S] [clusters=K] [spread=D] [ratio=O:B:S] [prefix=P] [out=файл]\n");
+                continue;
+            }
+            bool ok = true;
+            while (ok && iss >> opt) ok = parse_world_option(opt, spec, out_file);
+            if (!ok) { fail("Некорректный параметр '" + opt + "'\n"); continue; }
+            try {
+                if (!out_file.empty()) {
+                    if (writeRoster(spec, out_file)) out << "Записано " << spec.count << " NPC в '" << out_file << "'\n";
+                    else fail("Не удалось записать файл '" + out_file + "'\n");
+                } else {
+                    out << "Добавлено " << d.generate(spec) << " NPC\n";
+                }
+            } catch (const std::exception &e) {
+                fail(std::string("Ошибка генерации: ") + e.what() + "\n");
+            }
+
+        } else if (cmd == "stats") {
+            std::string arg;
+            iss >> arg;
+            if (arg.empty()) print_stats(d.stats(), d.statsEnabled());
+            else if (arg == "reset") { d.resetStats(); out << "Статистика сброшена\n"; }
+            else if (arg == "on" || arg == "off") d.enableStats(arg == "on");
+            else fail("Использование: stats [reset|on|off]\n");
 
         } else if (cmd == "clear") {
             d.clear();
-            std::cout << "Все NPC удалены\n";
+            out << "Все NPC удалены\n";
 
         } else if (cmd == "exit" || cmd == "quit") {
-            std::cout << "Игра окончена\n";
+            out << "Игра окончена\n";
             break;
 
         } else {
-            std::cout << "Неизвестная команда. Введите 'help' для вывода справки.\n";
+            fail("Неизвестная команда. Введите 'help' для вывода справки.\n");
         }
     }
+    finish_command();
 
-    return 0;
+    return failed ? 1 : 0;
 }
@@ -0,0 +1,13 @@
+#include "movement.hpp"
+#include <cmath>
+#include <numbers>
+
+void RandomWalk::steps(const MoveContext &ctx, std::span<double> dx, std::span<double> dy) {
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * std::numbers::pi);
+    for (std::size_t i = 0; i < ctx.kind.size(); ++i) {
+        const double a = angle(rng_);
+        const double d = moveDistance(ctx.kind[i]);
+        dx[i] = d * std::cos(a);
+        dy[i] = d * std::sin(a);
+    }
+}
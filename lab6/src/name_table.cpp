@@ -0,0 +1,150 @@
+#include "name_table.hpp"
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+static std::size_t hashName(std::string_view name) noexcept {
+    return std::hash<std::string_view>{}(name);
+}
+
+// slot holding `name`, or the empty slot where the probe stopped
+std::size_t NameTable::probe(std::string_view name, std::size_t hash) const noexcept {
+    const std::size_t mask = slots_.size() - 1;
+    const auto tag = static_cast<std::uint32_t>(hash);
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot &s = slots_[i];
+        if (s.id == npos) return i;
+        if (s.id != kTombstone && s.tag == tag && view(s.id) == name) return i;
+    }
+}
+
+void NameTable::rehash(std::size_t capacity) {
+    std::size_t cap = 16;
+    while (cap < capacity * 2) cap *= 2;   // keep the load factor at or below 1/2
+    std::vector<Slot> old(cap);
+    old.swap(slots_);
+    used_ = size_;
+    const std::size_t mask = cap - 1;
+    for (const Slot &s : old) {
+        if (s.id == npos || s.id == kTombstone) continue;
+        std::size_t i = hashName(view(s.id)) & mask;
+        while (slots_[i].id != npos) i = (i + 1) & mask;
+        slots_[i] = s;
+    }
+}
+
+void NameTable::reserve(std::size_t n) {
+    if (n * 2 > slots_.size()) rehash(n);
+}
+
+std::uint32_t NameTable::add(std::string_view name) {
+    // grows when full of live names, rebuilds in place when full of tombstones
+    if ((used_ + 1) * 2 > slots_.size()) rehash(size_ * 2 + 1);
+    std::uint32_t id;
+    if (!free_.empty()) {
+        id = free_.back();
+        free_.pop_back();
+        names_[id - bulkEnd_.size()].assign(name);
+    } else {
+        names_.emplace_back(name);
+        id = static_cast<std::uint32_t>(bulkEnd_.size() + names_.size() - 1);
+    }
+    const std::size_t hash = hashName(name);
+    // reuse the first tombstone on the probe path, if any
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t i = hash & mask;
+    while (slots_[i].id != npos && slots_[i].id != kTombstone) i = (i + 1) & mask;
+    if (slots_[i].id == npos) ++used_;
+    slots_[i] = {id, static_cast<std::uint32_t>(hash)};
+    ++size_;
+    return id;
+}
+
+void NameTable::unindex(std::uint32_t id) {
+    const std::string_view name = view(id);
+    const std::size_t i = probe(name, hashName(name));
+    if (slots_[i].id != id) return;   // not indexed (any more)
+    slots_[i].id = kTombstone;
+    --size_;
+}
+
+void NameTable::release(std::uint32_t id) {
+    unindex(id);
+    if (id < bulkEnd_.size()) return;   // its text stays in bulkText_ until clear()
+    names_[id - bulkEnd_.size()].clear();
+    free_.push_back(id);
+}
+
+std::uint32_t NameTable::find(std::string_view name) const noexcept {
+    if (slots_.empty()) return npos;
+    return slots_[probe(name, hashName(name))].id;
+}
+
+void NameTable::clear() noexcept {
+    bulkText_.reset();
+    bulkEnd_.clear();
+    names_.clear();
+    free_.clear();
+    slots_.clear();
+    size_ = used_ = 0;
+}
+
+void NameTable::assign(std::string_view text, std::span<const std::uint64_t> ends, std::span<std::uint8_t> take) {
+    // ids are 32 bits, and the tags below stand in for whole hashes
+    if (ends.size() > (std::size_t{1} << 31)) throw std::length_error("NameTable: too many names");
+    clear();
+    bulkText_ = std::make_unique_for_overwrite<char[]>(text.size());
+    if (!text.empty()) std::memcpy(bulkText_.get(), text.data(), text.size());
+    bulkEnd_.assign(ends.begin(), ends.end());
+
+    // a name's slot tag is the low half of its hash; with at most 2^31
+    // names there are at most 2^32 slots, so the tag gives the home slot too
+    struct Entry {
+        std::uint32_t id;
+        std::uint32_t tag;
+    };
+    const std::size_t count = ends.size();
+    std::vector<std::uint32_t> tags(count);
+    std::size_t taken = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!take[i]) continue;
+        tags[i] = static_cast<std::uint32_t>(hashName(view(static_cast<std::uint32_t>(i))));
+        ++taken;
+    }
+    rehash(taken);
+
+    // Names go in by the top bits of their home slot (a stable counting
+    // sort), so the index is written front to back instead of at random.
+    // Equal names share a home slot, so the first of them still comes
+    // first and the later ones find it.
+    const std::size_t mask = slots_.size() - 1;
+    constexpr unsigned kPartitionBits = 16;
+    const unsigned slotBits = static_cast<unsigned>(std::bit_width(mask));
+    const unsigned shift = slotBits > kPartitionBits ? slotBits - kPartitionBits : 0;
+    std::vector<std::uint32_t> start((mask >> shift) + 2, 0);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (take[i]) ++start[((tags[i] & mask) >> shift) + 1];
+    }
+    for (std::size_t p = 1; p < start.size(); ++p) start[p] += start[p - 1];
+    std::vector<Entry> order(taken);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (take[i]) order[start[(tags[i] & mask) >> shift]++] = {static_cast<std::uint32_t>(i), tags[i]};
+    }
+    // the names' text is only read when two tags match
+    for (const Entry &e : order) {
+        for (std::size_t i = e.tag & mask;; i = (i + 1) & mask) {
+            Slot &s = slots_[i];
+            if (s.id == npos) {
+                s = {e.id, e.tag};
+                ++size_;
+                ++used_;
+                break;
+            }
+            if (s.tag == e.tag && view(s.id) == view(e.id)) {   // an earlier record has this name
+                take[e.id] = 0;
+                break;
+            }
+        }
+    }
+}
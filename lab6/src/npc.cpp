@@ -1,6 +1,7 @@
 #include "npc.hpp"
-#include "combat_visitor.hpp" 
-#include "npc_types.hpp"
+#include "npc_columns.hpp"
+#include "npc_pool.hpp"
+#include <new>
 #include <utility>
 
 struct NPCBase::Impl {
@@ -8,29 +9,51 @@ struct NPCBase::Impl {
     double x{0.0};
     double y{0.0};
     bool alive{true};
+    NPCColumns *cols{nullptr};
+    std::uint32_t slot{0};
 
     Impl(std::string n, double xx, double yy) noexcept
         : name(std::move(n)), x(xx), y(yy) {}
 };
 
-NPCBase::NPCBase(std::string name, double x, double y) noexcept
-    : pimpl(new Impl(std::move(name), x, y)) {}
+NPCBase::NPCBase(std::string name, double x, double y, NPCPool *pool) noexcept
+    : pimpl(new (NPCPool::allocate(sizeof(Impl), pool)) Impl(std::move(name), x, y)) {}
 
 NPCBase::~NPCBase() {
-    delete pimpl;
+    if (!pimpl) return;   // moved from
+    pimpl->~Impl();
+    NPCPool::deallocate(pimpl);
 }
 
-std::string NPCBase::name() const noexcept { return pimpl->name; }
-double NPCBase::x() const noexcept { return pimpl->x; }
-double NPCBase::y() const noexcept { return pimpl->y; }
-bool NPCBase::alive() const noexcept { return pimpl->alive; }
-void NPCBase::markDead() noexcept { pimpl->alive = false; }
+NPCBase::NPCBase(NPCBase &&other) noexcept : pimpl(std::exchange(other.pimpl, nullptr)) {}
+
+NPCBase& NPCBase::operator=(NPCBase &&other) noexcept {
+    if (this != &other) {
+        if (pimpl) {
+            pimpl->~Impl();
+            NPCPool::deallocate(pimpl);
+        }
+        pimpl = std::exchange(other.pimpl, nullptr);
+    }
+    return *this;
+}
+
+void* NPCBase::operator new(std::size_t size) { return NPCPool::allocate(size, nullptr); }
+void* NPCBase::operator new(std::size_t size, NPCPool *pool) { return NPCPool::allocate(size, pool); }
+void NPCBase::operator delete(void *p) noexcept { NPCPool::deallocate(p); }
+void NPCBase::operator delete(void *p, NPCPool *) noexcept { NPCPool::deallocate(p); }
 
-std::string Orc::type() const noexcept { return "Orc"; }
-void Orc::accept(CombatVisitor &v) { v.visit(*this); }
+std::string_view NPCBase::name() const noexcept { return pimpl->name; }
+double NPCBase::x() const noexcept { return pimpl->cols ? pimpl->cols->x[pimpl->slot] : pimpl->x; }
+double NPCBase::y() const noexcept { return pimpl->cols ? pimpl->cols->y[pimpl->slot] : pimpl->y; }
+bool NPCBase::alive() const noexcept { return pimpl->cols ? pimpl->cols->alive[pimpl->slot] != 0 : pimpl->alive; }
 
-std::string Bear::type() const noexcept { return "Bear"; }
-void Bear::accept(CombatVisitor &v) { v.visit(*this); }
+void NPCBase::markDead() noexcept {
+    pimpl->alive = false;
+    if (pimpl->cols) pimpl->cols->alive[pimpl->slot] = 0;
+}
 
-std::string Squirrel::type() const noexcept { return "Squirrel"; }
-void Squirrel::accept(CombatVisitor &v) { v.visit(*this); }
+void NPCBase::bind(NPCColumns *cols, std::uint32_t slot) noexcept {
+    pimpl->cols = cols;
+    pimpl->slot = slot;
+}
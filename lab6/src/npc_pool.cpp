@@ -0,0 +1,63 @@
+#include "npc_pool.hpp"
+#include <algorithm>
+#include <new>
+
+NPCPool::~NPCPool() {
+    for (char *s : slabs_) ::operator delete(s);
+}
+
+void* NPCPool::allocate(std::size_t size, NPCPool *pool) {
+    const std::size_t total = sizeof(Header) + size;
+    const std::size_t sizeClass = (total + kGranule - 1) / kGranule - 1;
+    Header *h;
+    if (pool && sizeClass < kClassCount) {
+        h = static_cast<Header*>(pool->take(sizeClass));
+        h->owner = pool;
+    } else {
+        h = static_cast<Header*>(::operator new(total));
+        h->owner = nullptr;
+    }
+    h->sizeClass = static_cast<std::uint32_t>(sizeClass);
+    return h + 1;
+}
+
+void NPCPool::deallocate(void *p) noexcept {
+    if (!p) return;
+    Header *h = static_cast<Header*>(p) - 1;
+    if (h->owner) h->owner->give(h);
+    else ::operator delete(h);
+}
+
+void NPCPool::release() noexcept {
+    released_ = true;
+    if (live_ == 0) delete this;
+}
+
+void* NPCPool::take(std::size_t sizeClass) {
+    if (FreeBlock *b = free_[sizeClass]) {
+        free_[sizeClass] = b->next;
+        ++live_;
+        return b;
+    }
+    const std::size_t bytes = (sizeClass + 1) * kGranule;
+    if (static_cast<std::size_t>(bumpEnd_ - bump_) < bytes) {
+        // make room first, so a throwing push_back cannot leak the slab; the
+        // tail of the old slab (less than one block) is simply left unused
+        if (slabs_.size() == slabs_.capacity()) slabs_.reserve(std::max<std::size_t>(8, slabs_.size() * 2));
+        slabs_.push_back(static_cast<char*>(::operator new(kSlabBytes)));
+        bump_ = slabs_.back();
+        bumpEnd_ = bump_ + kSlabBytes;
+    }
+    void *p = bump_;
+    bump_ += bytes;
+    ++live_;   // only once the block is really handed out
+    return p;
+}
+
+void NPCPool::give(Header *h) noexcept {
+    const std::uint32_t sizeClass = h->sizeClass;
+    auto *b = reinterpret_cast<FreeBlock*>(h);
+    b->next = free_[sizeClass];
+    free_[sizeClass] = b;
+    if (--live_ == 0 && released_) delete this;
+}
@@ -0,0 +1,135 @@
+#include "spatial_grid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// upper bound on cells per axis; keeps tiny ranges from allocating huge grids
+static constexpr std::size_t kMaxDims = 1024;
+
+void SpatialGrid::build(const std::vector<double> &xs, const std::vector<double> &ys,
+                        double range, double worldSize) {
+    range_ = range;
+    worldSize_ = worldSize;
+    points_.resize(xs.size());
+    std::iota(points_.begin(), points_.end(), std::uint32_t{0});
+    buildPoints(xs, ys);
+}
+
+void SpatialGrid::build(const std::vector<double> &xs, const std::vector<double> &ys,
+                        std::span<const std::uint32_t> points, double range, double worldSize) {
+    range_ = range;
+    worldSize_ = worldSize;
+    points_.assign(points.begin(), points.end());
+    buildPoints(xs, ys);
+}
+
+void SpatialGrid::buildPoints(const std::vector<double> &xs, const std::vector<double> &ys) {
+    const std::size_t n = points_.size();
+
+    // slightly widen the cell so rounding in x / cellSize can never
+    // push two points within `range` more than one cell apart
+    const double minCell = std::max(range_, 1e-9) * (1.0 + 1e-9);
+    std::size_t dims = 1;
+    if (minCell < worldSize_) {
+        // about one point per cell is plenty; more cells only cost memory
+        const std::size_t byCount = static_cast<std::size_t>(std::sqrt(static_cast<double>(n))) + 1;
+        dims = std::min({static_cast<std::size_t>(worldSize_ / minCell), kMaxDims, byCount});
+        dims = std::max<std::size_t>(dims, 1);
+    }
+    dims_ = dims;
+    cellSize_ = worldSize_ / static_cast<double>(dims);
+
+    // counting sort by cell; every buffer keeps its capacity across builds,
+    // so rebuilding a grid of the same size does not allocate; a stable pass keeps indices ascending per cell
+    cellStart_.assign(dims * dims + 1, 0);
+    cellOf_.assign(xs.size(), kNoCell);
+    posOf_.resize(xs.size());
+    for (std::uint32_t i : points_) {
+        cellOf_[i] = cellOfPoint(xs[i], ys[i]);
+        ++cellStart_[cellOf_[i] + 1];
+    }
+    for (std::size_t c = 0; c < dims * dims; ++c) cellStart_[c + 1] += cellStart_[c];
+
+    items_.resize(n);
+    fill_.assign(cellStart_.begin(), cellStart_.end() - 1);
+    xs_.resize(n);
+    ys_.resize(n);
+    for (std::uint32_t i : points_) {
+        const std::uint32_t at = fill_[cellOf_[i]]++;
+        items_[at] = i;
+        posOf_[i] = at;
+        xs_[at] = xs[i];
+        ys_[at] = ys[i];
+    }
+}
+
+bool SpatialGrid::update(const std::vector<double> &xs, const std::vector<double> &ys,
+                         const std::vector<std::uint32_t> &moved) {
+    // a crosser costs one entry move per cell boundary between its old and
+    // new cell in row-major order
+    std::size_t work = 0;
+    for (std::uint32_t i : moved) {
+        const std::uint32_t from = cellOf_[i], to = cellOfPoint(xs[i], ys[i]);
+        if (from == kNoCell) continue;
+        work += from < to ? to - from : from - to;
+    }
+    if (work > items_.size()) {
+        buildPoints(xs, ys);
+        return false;
+    }
+
+    for (std::uint32_t i : moved) {
+        if (cellOf_[i] == kNoCell) continue;
+        const std::uint32_t to = cellOfPoint(xs[i], ys[i]);
+        if (to != cellOf_[i]) relocate(i, to);
+        xs_[posOf_[i]] = xs[i];
+        ys_[posOf_[i]] = ys[i];
+    }
+    return true;
+}
+
+// Frees the point's position, then passes the hole along the cells between
+// its old and new cell: each boundary cell gives up (or takes) one position
+// at its edge and moves one of its entries into the hole.
+void SpatialGrid::relocate(std::uint32_t idx, std::uint32_t to) noexcept {
+    const std::uint32_t from = cellOf_[idx];
+    std::uint32_t hole = posOf_[idx];
+    if (from < to) {
+        const std::uint32_t last = cellStart_[from + 1] - 1;
+        if (last != hole) { moveEntry(last, hole); hole = last; }
+        for (std::uint32_t c = from + 1; c < to; ++c) {
+            --cellStart_[c];                       // cell c takes the hole at its front
+            const std::uint32_t end = cellStart_[c + 1] - 1;
+            if (end != hole) { moveEntry(end, hole); hole = end; }
+        }
+        --cellStart_[to];
+    } else {
+        const std::uint32_t first = cellStart_[from];
+        if (first != hole) { moveEntry(first, hole); hole = first; }
+        for (std::uint32_t c = from - 1; c > to; --c) {
+            ++cellStart_[c + 1];                   // cell c takes the hole at its back
+            const std::uint32_t begin = cellStart_[c];
+            if (begin != hole) { moveEntry(begin, hole); hole = begin; }
+        }
+        ++cellStart_[to + 1];
+    }
+    items_[hole] = idx;
+    posOf_[idx] = hole;
+    cellOf_[idx] = to;
+}
+
+void SpatialGrid::moveEntry(std::uint32_t from, std::uint32_t to) noexcept {
+    items_[to] = items_[from];
+    xs_[to] = xs_[from];
+    ys_[to] = ys_[from];
+    posOf_[items_[to]] = to;
+}
+
+std::size_t SpatialGrid::cellX(double x) const noexcept {
+    if (!(x > 0.0)) return 0;
+    return std::min(static_cast<std::size_t>(x / cellSize_), dims_ - 1);
+}
+
+std::size_t SpatialGrid::cellY(double y) const noexcept {
+    return cellX(y);
+}
@@ -0,0 +1,71 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    for (unsigned w = 1; w < std::max(threads, 1u); ++w)
+        workers_.emplace_back([this, w] { workerLoop(w); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : workers_) t.join();
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain, const Body &body) {
+    if (count == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+    if (workers_.empty() || count <= grain) {
+        body(0, count, 0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        body_ = &body;
+        count_ = count;
+        grain_ = grain;
+        next_ = 0;
+        busy_ = static_cast<unsigned>(workers_.size());
+        ++generation_;
+    }
+    wake_.notify_all();
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lk(m_);
+    done_.wait(lk, [this] { return busy_ == 0; });
+    body_ = nullptr;
+}
+
+void ThreadPool::runChunks(unsigned worker) {
+    while (true) {
+        std::size_t b;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            if (next_ >= count_) return;
+            b = next_;
+            next_ = std::min(count_, next_ + grain_);
+        }
+        (*body_)(b, std::min(count_, b + grain_), worker);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            wake_.wait(lk, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+        runChunks(worker);
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            --busy_;
+        }
+        done_.notify_one();
+    }
+}
@@ -0,0 +1,126 @@
+#include "world_generator.hpp"
+#include "species.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <numbers>
+
+static constexpr double kWorldSide = 500.0;   // same map as Dungeon
+
+WorldGenerator::WorldGenerator(const WorldSpec &spec) : spec_(spec), rng_(spec.seed) {
+    double total = 0.0;
+    for (std::size_t k = 0; k < kNPCKindCount; ++k) {
+        total += spec_.ratio[k] > 0.0 ? spec_.ratio[k] : 0.0;
+        cumulative_[k] = total;
+    }
+    // all shares zero (or negative): fall back to equal shares
+    if (!(total > 0.0)) {
+        for (std::size_t k = 0; k < kNPCKindCount; ++k) cumulative_[k] = static_cast<double>(k + 1);
+    }
+
+    if (spec_.distribution == WorldDistribution::Clusters) {
+        centres_.resize(spec_.clusters > 0 ? spec_.clusters : 1);
+        for (auto &c : centres_) c = {uniform() * kWorldSide, uniform() * kWorldSide};
+    }
+}
+
+double WorldGenerator::uniform() {
+    return static_cast<double>(rng_() >> 11) * 0x1.0p-53;
+}
+
+// Box-Muller; every call pair consumes two uniforms
+double WorldGenerator::normal() {
+    if (haveSpare_) {
+        haveSpare_ = false;
+        return spareNormal_;
+    }
+    const double u = 1.0 - uniform();   // (0, 1], keeps log finite
+    const double v = uniform();
+    const double r = std::sqrt(-2.0 * std::log(u));
+    spareNormal_ = r * std::sin(2.0 * std::numbers::pi * v);
+    haveSpare_ = true;
+    return r * std::cos(2.0 * std::numbers::pi * v);
+}
+
+NPCKind WorldGenerator::pickKind() {
+    const double t = uniform() * cumulative_.back();
+    for (std::size_t k = 0; k < kNPCKindCount; ++k) {
+        if (t < cumulative_[k]) return static_cast<NPCKind>(k);
+    }
+    return static_cast<NPCKind>(kNPCKindCount - 1);
+}
+
+bool WorldGenerator::next(GeneratedNPC &out) {
+    if (produced_ >= spec_.count) return false;
+    out.index = produced_++;
+    out.kind = pickKind();
+    if (spec_.distribution == WorldDistribution::Clusters) {
+        const auto &c = centres_[static_cast<std::size_t>(uniform() * static_cast<double>(centres_.size()))];
+        // redraw points that fall off the map a few times before clamping,
+        // so blobs near an edge do not pile up on it
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            out.x = c[0] + normal() * spec_.spread;
+            out.y = c[1] + normal() * spec_.spread;
+            if (out.x >= 0.0 && out.x <= kWorldSide && out.y >= 0.0 && out.y <= kWorldSide) return true;
+        }
+        out.x = std::fmin(std::fmax(out.x, 0.0), kWorldSide);
+        out.y = std::fmin(std::fmax(out.y, 0.0), kWorldSide);
+        if (std::isnan(out.x) || std::isnan(out.y)) {   // NaN spread
+            out.x = c[0];
+            out.y = c[1];
+        }
+    } else {
+        out.x = uniform() * kWorldSide;
+        out.y = uniform() * kWorldSide;
+    }
+    return true;
+}
+
+bool parseWorldDistribution(std::string_view s, WorldDistribution &out) noexcept {
+    if (s == "uniform") { out = WorldDistribution::Uniform; return true; }
+    if (s == "clusters" || s == "gaussian") { out = WorldDistribution::Clusters; return true; }
+    return false;
+}
+
+std::string generatedName(const WorldSpec &spec, std::size_t index) {
+    char digits[24];
+    const auto res = std::to_chars(digits, digits + sizeof digits, index);
+    std::string name;
+    name.reserve(spec.namePrefix.size() + 1 + static_cast<std::size_t>(res.ptr - digits));
+    name.append(spec.namePrefix).append(1, '_').append(digits, res.ptr);
+    return name;
+}
+
+bool writeRoster(const WorldSpec &spec, const std::string &fname) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> f(std::fopen(fname.c_str(), "wb"), &std::fclose);
+    if (!f) return false;
+
+    // lines are collected into blocks of about 64 KiB; to_chars gives the
+    // shortest text that parses back to the same double
+    constexpr std::size_t kBlock = std::size_t{1} << 16;
+    std::string block;
+    block.reserve(kBlock + 256);
+    auto flush = [&] {
+        const bool ok = std::fwrite(block.data(), 1, block.size(), f.get()) == block.size();
+        block.clear();
+        return ok;
+    };
+    auto appendDouble = [&](double v) {
+        char digits[32];
+        block.append(digits, std::to_chars(digits, digits + sizeof digits, v).ptr);
+    };
+
+    WorldGenerator gen(spec);
+    GeneratedNPC npc;
+    while (gen.next(npc)) {
+        block.append(kindName(npc.kind)).append(1, ' ').append(generatedName(spec, npc.index)).append(1, ' ');
+        appendDouble(npc.x);
+        block.append(1, ' ');
+        appendDouble(npc.y);
+        block.append(1, '\n');
+        if (block.size() >= kBlock && !flush()) return false;
+    }
+    if (!block.empty() && !flush()) return false;
+    return std::fflush(f.get()) == 0;
+}
@@ -5,25 +5,66 @@
 #include <memory>
 #include <fstream>
 #include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <filesystem>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <span>
+#include <thread>
 
 #include "dungeon.hpp"
 #include "factory.hpp"
 #include "observer.hpp"
 #include "npc.hpp"
-#include "combat_visitor.hpp" 
+#include "combat_visitor.hpp"
+#include "distance_kernel.hpp"
+#include "file_logger.hpp"
+#include "npc_pool.hpp"
+#include "npc_variant.hpp"
+#include "name_table.hpp"
+#include "movement.hpp"
+#include "spatial_grid.hpp"
+#include "species.hpp"
+#include "world_generator.hpp"
 
 namespace fs = std::filesystem;
 
+// a death event with its names resolved, the way tests compare them
+struct NamedEvent {
+    std::string killer;
+    std::string victim;
+    double x;
+    double y;
+};
+
+static NamedEvent named(const DeathEvent &ev, const INameSource &names) {
+    return {std::string(names.nameOf(ev.killer)), std::string(names.nameOf(ev.victim)), ev.x, ev.y};
+}
+
 struct TestObserver : public IObserver {
-    std::vector<DeathEvent> events;
-    void onDeath(const DeathEvent &ev) override {
-        events.push_back(ev);
+    std::vector<NamedEvent> events;
+    void onDeath(const DeathEvent &ev, const INameSource &names) override {
+        events.push_back(named(ev, names));
+    }
+};
+
+// name source for events made up without a Dungeon
+struct TestNames : public INameSource {
+    std::vector<std::string> names;
+    NPCHandle add(std::string name) {
+        names.push_back(std::move(name));
+        return NPCHandle::make(static_cast<std::uint32_t>(names.size() - 1), 1);
+    }
+    std::string_view nameOf(NPCHandle h) const noexcept override {
+        return h && h.index() < names.size() ? std::string_view(names[h.index()]) : std::string_view{};
     }
 };
 
-static bool contains_event(const std::vector<DeathEvent> &evs, std::string killer, std::string victim) {
-    return std::any_of(evs.begin(), evs.end(), [&](const DeathEvent &e){
+static bool contains_event(const std::vector<NamedEvent> &evs, std::string killer, std::string victim) {
+    return std::any_of(evs.begin(), evs.end(), [&](const NamedEvent &e){
         return e.killer == killer && e.victim == victim;
     });
 }
@@ -71,15 +112,21 @@ TEST(FactoryTests, CreateFromLineParsing) {
 
 TEST(EventManagerTests, SubscribeAndNotify) {
     EventManager em;
+    TestNames names;
+    em.setNameSource(&names);
     auto obs = std::make_shared<TestObserver>();
     em.subscribe(obs);
     EXPECT_TRUE(obs->events.empty());
 
-    DeathEvent e{"Killer","Victim", 1.0, 2.0};
+    DeathEvent e{names.add("Killer"), names.add("Victim"), 1.0, 2.0};
     em.notify(e);
     ASSERT_EQ(obs->events.size(), 1u);
     EXPECT_EQ(obs->events[0].killer, "Killer");
     EXPECT_EQ(obs->events[0].victim, "Victim");
+
+    em.setNameSource(nullptr);
+    em.notify(e);
+    EXPECT_EQ(obs->events[1].killer, "");
 }
 
 // -------------------- Dungeon add/load/save tests --------------------
@@ -244,3 +291,1269 @@ TEST(VisitorTests, BasicWantsKillSemantics) {
     }
 }
 
+
+// -------------------- Spatial grid combat tests --------------------
+// runCombat only scans neighbouring grid cells; it must log exactly what the
+// original all-pairs scan logs, in the same order.
+
+struct NpcSpec { std::string type; std::string name; double x; double y; };
+
+static std::vector<NpcSpec> random_world(unsigned seed, size_t n, double side = 500.0) {
+    static const char *types[] = {"Orc", "Bear", "Squirrel"};
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coord(0.0, side);
+    std::vector<NpcSpec> w;
+    for (size_t i = 0; i < n; ++i)
+        w.push_back({types[rng() % 3], "n" + std::to_string(i), coord(rng), coord(rng)});
+    return w;
+}
+
+static std::vector<NamedEvent> brute_force_round(const std::vector<NpcSpec> &w, double range) {
+    std::vector<std::unique_ptr<NPCBase>> npcs;
+    for (auto &s : w) npcs.push_back(NPCFactory::create(s.type, s.name, s.x, s.y));
+    std::vector<std::string> killerOf(npcs.size());
+    std::vector<NamedEvent> evs;
+    for (size_t i = 0; i < npcs.size(); ++i) {
+        for (size_t j = i + 1; j < npcs.size(); ++j) {
+            double dx = npcs[i]->x() - npcs[j]->x();
+            double dy = npcs[i]->y() - npcs[j]->y();
+            if (dx*dx + dy*dy > range * range) continue;
+            CombatVisitor cv(npcs[i].get());
+            npcs[j]->accept(cv);
+            if (cv.victimDies() && killerOf[j].empty()) {
+                killerOf[j] = npcs[i]->name();
+                evs.push_back({std::string(npcs[i]->name()), std::string(npcs[j]->name()), npcs[j]->x(), npcs[j]->y()});
+            }
+            if (cv.attackerDies() && killerOf[i].empty()) {
+                killerOf[i] = npcs[j]->name();
+                evs.push_back({std::string(npcs[j]->name()), std::string(npcs[i]->name()), npcs[i]->x(), npcs[i]->y()});
+            }
+        }
+    }
+    return evs;
+}
+
+static void expect_same_events(const std::vector<NamedEvent> &got, const std::vector<NamedEvent> &want) {
+    ASSERT_EQ(got.size(), want.size());
+    for (size_t k = 0; k < got.size(); ++k) {
+        EXPECT_EQ(got[k].killer, want[k].killer) << "event " << k;
+        EXPECT_EQ(got[k].victim, want[k].victim) << "event " << k;
+        EXPECT_DOUBLE_EQ(got[k].x, want[k].x);
+        EXPECT_DOUBLE_EQ(got[k].y, want[k].y);
+    }
+}
+
+TEST(GridCombatTests, MatchesBruteForceOrder) {
+    for (double range : {0.0, 3.0, 12.5, 40.0, 800.0}) {
+        auto w = random_world(42u + static_cast<unsigned>(range), 1500);
+        Dungeon d;
+        for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+        auto obs = std::make_shared<TestObserver>();
+        d.events().subscribe(obs);
+        d.runCombat(range);
+        expect_same_events(obs->events, brute_force_round(w, range));
+    }
+}
+
+TEST(GridCombatTests, ClusteredPointsOnCellBorders) {
+    // integer coordinates put many NPCs exactly on cell edges and at distance == range
+    std::vector<NpcSpec> w;
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < 600; ++i) {
+        static const char *types[] = {"Orc", "Bear", "Squirrel"};
+        w.push_back({types[rng() % 3], "c" + std::to_string(i),
+                     static_cast<double>(rng() % 21) * 5.0, static_cast<double>(rng() % 21) * 5.0});
+    }
+    for (double range : {0.0, 5.0, 10.0}) {
+        Dungeon d;
+        for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+        auto obs = std::make_shared<TestObserver>();
+        d.events().subscribe(obs);
+        d.runCombat(range);
+        expect_same_events(obs->events, brute_force_round(w, range));
+    }
+}
+
+// -------------------- Kind tag / kill matrix tests --------------------
+
+TEST(VisitorTests, KillMatrixAgreesWithVisitor) {
+    const char *types[] = {"Orc", "Bear", "Squirrel"};
+    for (auto a : types) {
+        for (auto b : types) {
+            auto att = NPCFactory::create(a, "a", 0, 0);
+            auto def = NPCFactory::create(b, "b", 0, 0);
+            EXPECT_EQ(att->kind(), kindFromName(a));
+            CombatVisitor vis(att.get());
+            def->accept(vis);
+            EXPECT_EQ(vis.victimDies(), kills(att->kind(), def->kind())) << a << " vs " << b;
+            EXPECT_EQ(vis.attackerDies(), kills(def->kind(), att->kind())) << a << " vs " << b;
+        }
+    }
+    EXPECT_FALSE(kills(NPCKind::Unknown, NPCKind::Orc));
+}
+
+TEST(VisitorTests, RegistryDrivesNamesFactoryAndSpeeds) {
+    for (size_t k = 0; k < kNPCKindCount; ++k) {
+        const auto kind = static_cast<NPCKind>(k);
+        const std::string name(kindName(kind));
+        EXPECT_EQ(kindFromName(name), kind);
+        std::string upper = name;
+        for (char &c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        EXPECT_EQ(kindFromName(upper), NPCKind::Unknown);
+        EXPECT_EQ(kindFromNameIgnoreCase(upper), kind);
+
+        auto npc = NPCFactory::create(kind, "n", 1, 2);
+        ASSERT_NE(npc, nullptr);
+        EXPECT_EQ(npc->kind(), kind);
+        EXPECT_EQ(npc->type(), name);
+        EXPECT_GT(moveDistance(kind), 0.0);
+    }
+    for (const char *bad : {"", "Or", "Orcs", "Elf", "Squirrel "}) {
+        EXPECT_EQ(kindFromNameIgnoreCase(bad), NPCKind::Unknown) << bad;
+        EXPECT_EQ(NPCFactory::create(bad, "n", 1, 2), nullptr) << bad;
+    }
+    EXPECT_EQ(NPCFactory::create(NPCKind::Unknown, "n", 1, 2), nullptr);
+    EXPECT_EQ(kindName(NPCKind::Unknown), "Unknown");
+    EXPECT_DOUBLE_EQ(moveDistance(NPCKind::Orc), Orc::kMoveDistance);
+}
+
+TEST(VisitorTests, VariantStorageFightsLikeTheVisitor) {
+    for (size_t a = 0; a < kNPCKindCount; ++a) {
+        for (size_t b = 0; b < kNPCKindCount; ++b) {
+            const auto ka = static_cast<NPCKind>(a), kb = static_cast<NPCKind>(b);
+            auto att = NPCFactory::create(ka, "a", 0, 0);
+            auto def = NPCFactory::create(kb, "b", 0, 0);
+            CombatVisitor vis(att.get());
+            def->accept(vis);
+            const CombatOutcome out = fight(*makeNPCVariant(ka, "a", 0, 0), *makeNPCVariant(kb, "b", 0, 0));
+            EXPECT_EQ(out.victimDies, vis.victimDies()) << a << " vs " << b;
+            EXPECT_EQ(out.attackerDies, vis.attackerDies()) << a << " vs " << b;
+        }
+    }
+    EXPECT_FALSE(makeNPCVariant(NPCKind::Unknown, "x", 0, 0));
+
+    // values keep their state through vector growth and go back to the pool
+    NPCPool *pool = new NPCPool;
+    {
+        std::vector<NPCVariant> npcs;
+        for (int i = 0; i < 1000; ++i)
+            npcs.push_back(*makeNPCVariant(static_cast<NPCKind>(i % kNPCKindCount), "v" + std::to_string(i), i % 500, 1, pool));
+        EXPECT_EQ(pool->liveBlocks(), 1000u);
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_EQ(kindOf(npcs[i]), static_cast<NPCKind>(i % kNPCKindCount));
+            EXPECT_EQ(baseOf(npcs[i]).name(), "v" + std::to_string(i));
+            EXPECT_EQ(baseOf(npcs[i]).type(), kindName(kindOf(npcs[i])));
+            EXPECT_DOUBLE_EQ(baseOf(npcs[i]).x(), i % 500);
+        }
+        npcs.erase(npcs.begin(), npcs.begin() + 500);
+        EXPECT_EQ(pool->liveBlocks(), 500u);
+        EXPECT_EQ(baseOf(npcs.front()).name(), "v500");
+    }
+    EXPECT_EQ(pool->liveBlocks(), 0u);
+    pool->release();
+}
+
+// -------------------- Distance kernel tests --------------------
+
+TEST(DistanceKernelTests, AllKernelsAgreeWithScalar) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> coord(0.0, 500.0);
+    for (std::size_t count : {0u, 1u, 7u, 64u, 65u, 200u, 1031u}) {
+        std::vector<double> xs(count), ys(count);
+        for (std::size_t k = 0; k < count; ++k) { xs[k] = coord(rng); ys[k] = coord(rng); }
+        if (count > 3) { xs[3] = 260.0; ys[3] = 250.0; }  // exactly on the radius
+        std::vector<std::uint64_t> want((count + 63) / 64 + 1, ~0ull), got = want;
+        inRangeMask(DistanceKernel::Scalar, 250.0, 250.0, xs.data(), ys.data(), count, 100.0, want.data());
+        for (auto k : {DistanceKernel::SSE2, DistanceKernel::AVX2, activeDistanceKernel()}) {
+            std::fill(got.begin(), got.end(), ~0ull);
+            inRangeMask(k, 250.0, 250.0, xs.data(), ys.data(), count, 100.0, got.data());
+            EXPECT_EQ(got, want) << distanceKernelName(k) << " count=" << count;
+        }
+        if (count > 3) EXPECT_TRUE(want[0] & (1ull << 3));
+    }
+}
+
+// -------------------- Parallel combat tests --------------------
+
+TEST(ParallelCombatTests, EventsIdenticalForAnyThreadCount) {
+    auto w = random_world(99, 6000);
+    std::vector<NamedEvent> serial;
+    for (unsigned threads : {1u, 2u, 4u, 7u}) {
+        Dungeon d;
+        d.setThreads(threads);
+        EXPECT_EQ(d.threads(), threads);
+        for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+        auto obs = std::make_shared<TestObserver>();
+        d.events().subscribe(obs);
+        d.runCombat(15.0);
+        if (threads == 1) serial = obs->events;
+        else expect_same_events(obs->events, serial);
+    }
+    EXPECT_FALSE(serial.empty());
+}
+
+// -------------------- Name index tests --------------------
+
+TEST(NameIndexTests, LookupAndRemoveStayInSync) {
+    Dungeon d;
+    EXPECT_TRUE(d.addNPC(NPCFactory::create("Orc", "A", 1, 1)));
+    EXPECT_TRUE(d.addNPC(NPCFactory::create("Bear", "B", 2, 2)));
+    EXPECT_TRUE(d.addNPC(NPCFactory::create("Squirrel", "C", 300, 300)));
+    EXPECT_EQ(d.size(), 3u);
+    ASSERT_NE(d.find("C"), nullptr);
+    EXPECT_EQ(d.find("C")->type(), "Squirrel");
+    EXPECT_DOUBLE_EQ(d.find("C")->x(), 300.0);
+
+    // removal frees the name and keeps later NPCs reachable
+    EXPECT_TRUE(d.removeNPC("A"));
+    EXPECT_FALSE(d.removeNPC("A"));
+    EXPECT_FALSE(d.contains("A"));
+    ASSERT_NE(d.find("C"), nullptr);
+    EXPECT_DOUBLE_EQ(d.find("C")->y(), 300.0);
+    EXPECT_TRUE(d.addNPC(NPCFactory::create("Orc", "A", 5, 5)));
+
+    // combat removal: the Orc "A" kills Bear "B"
+    d.runCombat(10.0);
+    EXPECT_FALSE(d.contains("B"));
+    EXPECT_TRUE(d.addNPC(NPCFactory::create("Bear", "B", 400, 400)));
+    EXPECT_EQ(d.size(), 3u);
+
+    d.clear();
+    EXPECT_EQ(d.size(), 0u);
+    EXPECT_EQ(d.find("C"), nullptr);
+    EXPECT_TRUE(d.addNPC(NPCFactory::create("Orc", "C", 0, 0)));
+}
+
+TEST(NameIndexTests, LoadSkipsDuplicateNames) {
+    const std::string fname = "ut_test_dups.txt";
+    {
+        std::ofstream f(fname);
+        f << "Orc X 1 1\nBear X 2 2\nBear Y 3 3\nSquirrel Z 600 1\nSquirrel Z 4 4\n";
+    }
+    Dungeon d;
+    d.addNPC(NPCFactory::create("Orc", "old", 1, 1));
+    ASSERT_TRUE(d.loadFromFile(fname));
+    EXPECT_EQ(d.size(), 3u);
+    EXPECT_FALSE(d.contains("old"));
+    ASSERT_NE(d.find("X"), nullptr);
+    EXPECT_EQ(d.find("X")->type(), "Orc");
+    ASSERT_NE(d.find("Z"), nullptr);
+    EXPECT_DOUBLE_EQ(d.find("Z")->x(), 4.0);
+    std::error_code ec;
+    fs::remove(fname, ec);
+}
+
+// -------------------- Roster parser tests --------------------
+
+TEST(FactoryTests, ParseLineMatchesStreamRules) {
+    NPCRecord r;
+    ASSERT_TRUE(NPCFactory::parseLine("  Bear\tPim  +1.5e1 -0.0 trailing words\r", r));
+    EXPECT_EQ(r.type, "Bear");
+    EXPECT_EQ(r.name, "Pim");
+    EXPECT_DOUBLE_EQ(r.x, 15.0);
+    EXPECT_DOUBLE_EQ(r.y, 0.0);
+    ASSERT_TRUE(NPCFactory::parseLine("Orc a .5 7xyz", r));
+    EXPECT_DOUBLE_EQ(r.x, 0.5);
+    EXPECT_DOUBLE_EQ(r.y, 7.0);
+
+    EXPECT_FALSE(NPCFactory::parseLine("", r));
+    EXPECT_FALSE(NPCFactory::parseLine("Orc a 1", r));
+    EXPECT_FALSE(NPCFactory::parseLine("Orc a 1x 2", r));
+    EXPECT_FALSE(NPCFactory::parseLine("Orc a 1 y", r));
+    EXPECT_FALSE(NPCFactory::parseLine("Orc a nan 2", r));
+    EXPECT_FALSE(NPCFactory::parseLine("Orc a 1 +", r));
+
+    // x and y against operator>> itself
+    for (const char *xy : {"+-1 2", "+-0 2", "-+1 2", "++1 2", "1e-400 2", "-1e-400 2", "0.0001e-320 2",
+                           "1e999 2", "123456789e-330 2", "10+5 20", "1.5.5 2", "1e 2", "1e+ 2", "1 2e",
+                           "1 2e5e", "- 2", ". 2", "+.5 2", "0x10 2", "-inf 2", "1,5 2", "1e-400x 2",
+                           "4.9e-324 2", "00012 3", "7 -0.0junk"}) {
+        std::istringstream in(xy);
+        double x = 0.0, y = 0.0;
+        const bool want = static_cast<bool>(in >> x >> y);
+        const bool got = NPCFactory::parseLine(std::string("Orc a ") + xy, r);
+        EXPECT_EQ(got, want) << xy;
+        if (got && want) {
+            EXPECT_EQ(r.x, x) << xy;
+            EXPECT_EQ(r.y, y) << xy;
+            EXPECT_EQ(std::signbit(r.x), std::signbit(x)) << xy;
+        }
+    }
+}
+
+TEST(DungeonTests, LoadSkipsBadLinesAndHandlesMissingNewline) {
+    const std::string fname = "ut_test_load.txt";
+    {
+        std::ofstream f(fname, std::ios::binary);
+        f << "Orc A 1 1\r\n\n"
+             "Dragon B 2 2\n"
+             "Bear C -1 2\n"
+             "Bear D 2\n"
+             "Squirrel E 1e2 500";   // last line without '\n'
+    }
+    Dungeon d;
+    ASSERT_TRUE(d.loadFromFile(fname));
+    EXPECT_EQ(d.size(), 2u);
+    EXPECT_TRUE(d.contains("A"));
+    ASSERT_NE(d.find("E"), nullptr);
+    EXPECT_DOUBLE_EQ(d.find("E")->x(), 100.0);
+    EXPECT_FALSE(d.loadFromFile("ut_no_such_file.txt"));
+    EXPECT_EQ(d.size(), 2u);
+
+    { std::ofstream f(fname, std::ios::trunc); }
+    ASSERT_TRUE(d.loadFromFile(fname));
+    EXPECT_EQ(d.size(), 0u);
+    std::error_code ec;
+    fs::remove(fname, ec);
+}
+
+// -------------------- Binary snapshot tests --------------------
+
+TEST(SnapshotTests, BinaryRoundTripIsExact) {
+    const std::string fname = "ut_test_snapshot.bin";
+    Dungeon d;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> coord(0.0, 500.0);
+    const char *types[] = {"Orc", "Bear", "Squirrel"};
+    std::vector<NpcSpec> w;
+    for (size_t i = 0; i < 300; ++i) {
+        // names of varying length, including ones longer than the SSO buffer
+        w.push_back({types[i % 3], std::string(1 + i % 40, static_cast<char>('a' + i % 26)) + std::to_string(i),
+                     coord(rng), coord(rng)});
+        ASSERT_TRUE(d.addNPC(NPCFactory::create(w.back().type, w.back().name, w.back().x, w.back().y)));
+    }
+    ASSERT_TRUE(d.saveBinary(fname));
+
+    Dungeon d2;
+    d2.addNPC(NPCFactory::create("Orc", "stale", 1, 1));
+    ASSERT_TRUE(d2.loadBinary(fname));
+    EXPECT_EQ(d2.size(), w.size());
+    EXPECT_FALSE(d2.contains("stale"));
+    for (auto &s : w) {
+        const NPCBase *p = d2.find(s.name);
+        ASSERT_NE(p, nullptr) << s.name;
+        EXPECT_EQ(p->type(), s.type);
+        EXPECT_EQ(p->x(), s.x);   // bit-exact, not just close
+        EXPECT_EQ(p->y(), s.y);
+    }
+
+    // both dungeons fight identically
+    auto o1 = std::make_shared<TestObserver>(), o2 = std::make_shared<TestObserver>();
+    d.events().subscribe(o1);
+    d2.events().subscribe(o2);
+    d.runCombat(30.0);
+    d2.runCombat(30.0);
+    expect_same_events(o2->events, o1->events);
+    std::error_code ec;
+    fs::remove(fname, ec);
+}
+
+TEST(SnapshotTests, LoadedNPCsBehaveLikeAddedOnes) {
+    const std::string fname = "ut_test_snapshot_churn.bin";
+    WorldSpec spec;
+    spec.count = 2000;
+    spec.seed = 9;
+    Dungeon d;
+    d.generate(spec);
+    ASSERT_TRUE(d.saveBinary(fname));
+
+    Dungeon bin;
+    ASSERT_TRUE(bin.loadBinary(fname));
+    ASSERT_EQ(bin.size(), d.size());
+    const std::string first = generatedName(spec, 0), last = generatedName(spec, spec.count - 1);
+    const NPCHandle h = bin.handleOf(last);
+    ASSERT_TRUE(h);
+    EXPECT_EQ(bin.nameOf(h), last);
+
+    // a removed name can be taken again, and lookups survive compaction
+    ASSERT_TRUE(bin.removeNPC(first));
+    EXPECT_FALSE(bin.contains(first));
+    ASSERT_TRUE(bin.addNPC(NPCFactory::create("Orc", first, 1.0, 2.0, bin.pool())));
+    bin.compact();
+    EXPECT_EQ(bin.find(first)->type(), "Orc");
+    EXPECT_EQ(bin.find(h), bin.find(last));
+    EXPECT_EQ(bin.find(last)->x(), d.find(last)->x());
+
+    // both dungeons fight identically
+    auto o1 = std::make_shared<TestObserver>(), o2 = std::make_shared<TestObserver>();
+    d.removeNPC(first);
+    d.addNPC(NPCFactory::create("Orc", first, 1.0, 2.0, d.pool()));
+    d.events().subscribe(o1);
+    bin.events().subscribe(o2);
+    d.runCombat(15.0);
+    bin.runCombat(15.0);
+    expect_same_events(o2->events, o1->events);
+    EXPECT_EQ(bin.size(), d.size());
+    EXPECT_EQ(bin.contains(last), d.contains(last));
+    std::error_code ec;
+    fs::remove(fname, ec);
+}
+
+TEST(SnapshotTests, RejectsForeignAndTruncatedFiles) {
+    const std::string fname = "ut_test_snapshot_bad.bin";
+    Dungeon d;
+    d.addNPC(NPCFactory::create("Orc", "keep", 1, 1));
+    { std::ofstream f(fname); f << "Orc A 1 1\n"; }
+    EXPECT_FALSE(d.loadBinary(fname));
+    EXPECT_EQ(d.size(), 1u);
+
+    ASSERT_TRUE(d.saveBinary(fname));
+    fs::resize_file(fname, fs::file_size(fname) - 1);
+    EXPECT_FALSE(d.loadBinary(fname));
+    EXPECT_TRUE(d.contains("keep"));
+
+    Dungeon empty;
+    ASSERT_TRUE(empty.saveBinary(fname));
+    ASSERT_TRUE(d.loadBinary(fname));
+    EXPECT_EQ(d.size(), 0u);
+    std::error_code ec;
+    fs::remove(fname, ec);
+}
+
+// -------------------- Async event dispatch tests --------------------
+
+struct BatchObserver : public IObserver {
+    std::vector<NamedEvent> events;
+    std::vector<size_t> batchSizes;
+    std::thread::id thread;
+    void onDeath(const DeathEvent &ev, const INameSource &names) override { events.push_back(named(ev, names)); }
+    void onDeaths(std::span<const DeathEvent> evs, const INameSource &names) override {
+        thread = std::this_thread::get_id();
+        batchSizes.push_back(evs.size());
+        for (auto &ev : evs) events.push_back(named(ev, names));
+    }
+};
+
+TEST(EventManagerTests, AsyncBatchesKeepOrderAndFlushIsABarrier) {
+    EventManager em;
+    TestNames names;
+    em.setNameSource(&names);
+    auto batches = std::make_shared<BatchObserver>();
+    auto single = std::make_shared<TestObserver>();
+    em.subscribe(batches);
+    em.subscribe(single);
+    em.setAsync(true);
+    EXPECT_TRUE(em.async());
+
+    std::vector<NamedEvent> want;
+    for (int round = 0; round < 50; ++round) {
+        std::vector<DeathEvent> batch;
+        for (int k = 0; k <= round % 4; ++k) {
+            const std::string killer = "k" + std::to_string(round), victim = "v" + std::to_string(k);
+            batch.push_back({names.add(killer), names.add(victim), 1.0 * round, 1.0 * k});
+            want.push_back({killer, victim, 1.0 * round, 1.0 * k});
+        }
+        em.publish(batch);
+    }
+    // names were copied at publish time; the source may change before delivery
+    names.names.assign(names.names.size(), "renamed");
+    em.flush();
+    expect_same_events(batches->events, want);
+    expect_same_events(single->events, want);
+    EXPECT_EQ(batches->batchSizes.size(), 50u);
+    EXPECT_NE(batches->thread, std::this_thread::get_id());
+
+    em.setAsync(false);
+    const DeathEvent last{names.add("a"), names.add("b"), 0, 0};
+    em.publish(std::span(&last, 1));
+    EXPECT_EQ(batches->thread, std::this_thread::get_id());
+    ASSERT_EQ(batches->events.size(), want.size() + 1);
+    EXPECT_EQ(batches->events.back().killer, "a");
+}
+
+// subscribes a TestObserver of its own from inside its first callback
+struct RecruitingObserver : public IObserver {
+    EventManager *em = nullptr;
+    std::shared_ptr<TestObserver> recruit;
+    void onDeath(const DeathEvent &, const INameSource &) override {
+        if (recruit) return;
+        recruit = std::make_shared<TestObserver>();
+        em->subscribe(recruit);
+    }
+};
+
+TEST(EventManagerTests, ObserversMaySubscribeFromTheirCallback) {
+    TestNames names;
+    const DeathEvent ev{names.add("killer"), names.add("victim"), 1.0, 2.0};
+    for (bool async : {false, true}) {
+        EventManager em;
+        em.setNameSource(&names);
+        em.setAsync(async);
+        auto recruiter = std::make_shared<RecruitingObserver>();
+        recruiter->em = &em;
+        em.subscribe(recruiter);
+
+        const DeathEvent batch[] = {ev};
+        em.publish(batch);   // used to deadlock on the observer lock
+        em.flush();
+        ASSERT_NE(recruiter->recruit, nullptr);
+        EXPECT_TRUE(recruiter->recruit->events.empty());   // joined after this batch
+        em.publish(batch);
+        em.notify(ev);
+        em.flush();
+        EXPECT_EQ(recruiter->recruit->events.size(), 2u);
+    }
+}
+
+TEST(EventManagerTests, AsyncCombatMatchesSync) {
+    auto w = random_world(3, 2000);
+    Dungeon sync, async;
+    async.events().setAsync(true);
+    for (auto &s : w) {
+        sync.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+        async.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+    }
+    auto o1 = std::make_shared<TestObserver>();
+    auto o2 = std::make_shared<BatchObserver>();
+    sync.events().subscribe(o1);
+    async.events().subscribe(o2);
+    sync.runCombat(12.0);
+    async.runCombat(12.0);
+    async.events().flush();
+    expect_same_events(o2->events, o1->events);
+    EXPECT_EQ(o2->batchSizes.size(), 1u);
+}
+
+// -------------------- File logger tests --------------------
+
+static std::string read_file(const std::string &fname) {
+    std::ifstream f(fname, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+TEST(FileLoggerTests, BuffersUntilBatchEndAndKeepsLineFormat) {
+    const std::string fname = "ut_test_log.txt";
+    std::error_code ec;
+    fs::remove(fname, ec);
+    {
+        FileLoggerOptions opts;
+        opts.flushEachBatch = true;
+        FileLogger log(fname, opts);
+        ASSERT_TRUE(log.good());
+        TestNames names;
+        const NPCHandle bob = names.add("Bob"), pim = names.add("Pim");
+        log.onDeath({bob, pim, 10, 11.5}, names);
+        EXPECT_EQ(read_file(fname), "");   // still buffered
+        std::vector<DeathEvent> round{{pim, names.add("chuck"), 10, 12}};
+        log.onDeaths(round, names);
+        EXPECT_EQ(read_file(fname), "Bob убил Pim в точке (10,11.5)\nPim убил chuck в точке (10,12)\n");
+        log.onDeath({names.add("A"), names.add("B"), 0.125, 500}, names);
+    }
+    // the destructor writes out the rest, appending to what is there
+    EXPECT_EQ(read_file(fname).substr(read_file(fname).rfind("A убил")), "A убил B в точке (0.125,500)\n");
+    fs::remove(fname, ec);
+}
+
+TEST(FileLoggerTests, SizeThresholdAndRotation) {
+    const std::string fname = "ut_test_rot.txt";
+    std::error_code ec;
+    for (auto f : {fname, fname + ".1", fname + ".2", fname + ".3"}) fs::remove(f, ec);
+    {
+        FileLoggerOptions opts;
+        opts.flushEachBatch = false;
+        opts.flushThreshold = 1;       // every line goes straight out
+        opts.rotateBytes = 100;
+        opts.keepFiles = 2;
+        FileLogger log(fname, opts);
+        TestNames names;
+        const NPCHandle victim = names.add("victim");
+        for (int i = 0; i < 20; ++i) log.onDeath({names.add("killer" + std::to_string(i)), victim, 1, 2}, names);
+    }
+    EXPECT_TRUE(fs::exists(fname));
+    EXPECT_TRUE(fs::exists(fname + ".1"));
+    EXPECT_TRUE(fs::exists(fname + ".2"));
+    EXPECT_FALSE(fs::exists(fname + ".3"));
+    for (auto f : {fname, fname + ".1", fname + ".2"}) {
+        const std::string text = read_file(f);
+        EXPECT_LE(text.size(), 100u) << f;
+        EXPECT_EQ(text.back(), '\n') << f;
+    }
+    // the newest lines are in the live file
+    EXPECT_NE(read_file(fname).find("killer19 "), std::string::npos);
+    for (auto f : {fname, fname + ".1", fname + ".2"}) fs::remove(f, ec);
+}
+
+TEST(FileLoggerTests, FailedWritesKeepLinesAndReportIt) {
+    if (!fs::exists("/dev/full")) GTEST_SKIP() << "needs /dev/full";
+    FileLoggerOptions opts;
+    opts.bufferBytes = 100;
+    FileLogger log("/dev/full", opts);   // opens, but every write fails
+    TestNames names;
+    const NPCHandle a = names.add("a"), b = names.add("b");
+    std::vector<DeathEvent> round{{a, b, 1, 2}};
+    log.onDeaths(round, names);
+    EXPECT_FALSE(log.good());
+    EXPECT_EQ(log.lostLines(), 0u);   // still buffered for the next flush
+    for (int i = 0; i < 10; ++i) log.onDeaths(round, names);
+    EXPECT_GT(log.lostLines(), 0u);   // the buffer is bounded
+    EXPECT_FALSE(log.good());
+}
+
+// -------------------- NPC pool tests --------------------
+
+TEST(PoolTests, DungeonNPCsComeFromItsPoolAndSlotsAreReused) {
+    Dungeon d;
+    NPCPool *pool = d.pool();
+    ASSERT_NE(pool, nullptr);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_TRUE(d.addNPC(NPCFactory::create("Squirrel", "s" + std::to_string(i), i, i, pool)));
+    // one block for the object and one for its state
+    EXPECT_EQ(pool->liveBlocks(), 200u);
+    const size_t slabs = pool->slabCount();
+
+    // rejected NPCs give their blocks back at once, removed ones when their
+    // tombstone is compacted away
+    EXPECT_FALSE(d.addNPC(NPCFactory::create("Orc", "s1", 1, 1, pool)));
+    EXPECT_TRUE(d.removeNPC("s5"));
+    EXPECT_EQ(pool->liveBlocks(), 200u);
+    d.compact();
+    EXPECT_EQ(pool->liveBlocks(), 198u);
+
+    d.clear();
+    EXPECT_EQ(pool->liveBlocks(), 0u);
+    for (int i = 0; i < 100; ++i)
+        d.addNPC(NPCFactory::create("Bear", "b" + std::to_string(i), i, i, pool));
+    EXPECT_EQ(pool->slabCount(), slabs);   // recycled, no new slabs
+}
+
+TEST(PoolTests, NPCMayOutliveItsDungeon) {
+    std::unique_ptr<NPCBase> survivor;
+    {
+        Dungeon d;
+        survivor = NPCFactory::create("Orc", "late", 3, 4, d.pool());
+        d.loadFromFile("ut_no_such_file.txt");
+    }
+    EXPECT_EQ(survivor->name(), "late");
+    EXPECT_DOUBLE_EQ(survivor->y(), 4.0);
+    survivor.reset();   // last block returns and frees the released pool
+
+    auto heap = NPCFactory::create("Bear", "heap", 1, 2);
+    EXPECT_EQ(heap->type(), "Bear");
+}
+
+TEST(NameIndexTests, ChurnKeepsIndexConsistent) {
+    NameTable t;
+    std::map<std::string, std::uint32_t> live;
+    std::mt19937 rng(17);
+    for (int step = 0; step < 20000; ++step) {
+        const std::string name = "n" + std::to_string(rng() % 500);
+        auto it = live.find(name);
+        if (it == live.end()) {
+            ASSERT_EQ(t.find(name), NameTable::npos);
+            live[name] = t.add(name);
+        } else {
+            ASSERT_EQ(t.find(name), it->second);
+            ASSERT_EQ(t.view(it->second), name);
+            t.release(it->second);
+            live.erase(it);
+        }
+        ASSERT_EQ(t.size(), live.size());
+    }
+}
+
+TEST(NameIndexTests, AssignIndexesTheFirstOfRepeatedNames) {
+    const std::vector<std::string> names = {"a", "bb", "a", "", "skip", "bb", "c"};
+    std::string text;
+    std::vector<std::uint64_t> ends;
+    for (auto &n : names) ends.push_back((text += n).size());
+    std::vector<std::uint8_t> take = {1, 1, 1, 0, 0, 1, 1};
+
+    NameTable t;
+    t.add("old");
+    t.assign(text, ends, take);
+    EXPECT_EQ(take, (std::vector<std::uint8_t>{1, 1, 0, 0, 0, 0, 1}));
+    EXPECT_EQ(t.size(), 3u);
+    EXPECT_EQ(t.find("old"), NameTable::npos);
+    EXPECT_EQ(t.find("a"), 0u);
+    EXPECT_EQ(t.find("bb"), 1u);
+    EXPECT_EQ(t.find("skip"), NameTable::npos);
+    EXPECT_EQ(t.view(4), "skip");
+
+    // bulk ids are released for good; names added later get fresh ones
+    t.release(0);
+    EXPECT_EQ(t.find("a"), NameTable::npos);
+    const std::uint32_t id = t.add("a");
+    EXPECT_EQ(id, names.size());
+    EXPECT_EQ(t.view(id), "a");
+    EXPECT_EQ(t.find("a"), id);
+    EXPECT_EQ(t.view(6), "c");
+}
+
+// -------------------- Simulation tests --------------------
+
+TEST(SimulationTests, RoundsMatchRepeatedRunCombat) {
+    auto w = random_world(5, 3000);
+    Dungeon looped, simulated;
+    for (auto &s : w) {
+        looped.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+        simulated.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+    }
+    auto loopObs = std::make_shared<TestObserver>();
+    auto simObs = std::make_shared<TestObserver>();
+    looped.events().subscribe(loopObs);
+    simulated.events().subscribe(simObs);
+
+    SimulationResult res = simulated.simulate(20.0);
+    ASSERT_TRUE(res.stable);
+    ASSERT_FALSE(res.rounds.empty());
+    EXPECT_EQ(res.rounds.back().deaths, 0u);
+
+    size_t deaths = 0;
+    for (const CombatRound &r : res.rounds) {
+        const size_t before = looped.size();
+        looped.runCombat(20.0);
+        EXPECT_EQ(before - looped.size(), r.deaths);
+        EXPECT_EQ(looped.size(), r.survivors);
+        deaths += r.deaths;
+    }
+    EXPECT_EQ(deaths, w.size() - simulated.size());
+    expect_same_events(simObs->events, loopObs->events);
+}
+
+TEST(SimulationTests, MaxRoundsAndPeacefulSpecies) {
+    Dungeon d;
+    d.addNPC(NPCFactory::create("Orc", "O1", 0.0, 0.0));
+    d.addNPC(NPCFactory::create("Bear", "B1", 1.0, 0.0));
+    d.addNPC(NPCFactory::create("Squirrel", "S1", 300.0, 300.0));
+
+    // a bounded run stops after its rounds even if more fighting could follow
+    SimulationResult one = d.simulate(5.0, 1);
+    ASSERT_EQ(one.rounds.size(), 1u);
+    EXPECT_EQ(one.rounds[0].deaths, 1u);
+    EXPECT_EQ(one.rounds[0].survivors, 2u);
+    EXPECT_FALSE(one.stable);
+
+    // Orc and Squirrel cannot hurt each other: stable without another round
+    SimulationResult rest = d.simulate(1000.0);
+    EXPECT_TRUE(rest.stable);
+    EXPECT_TRUE(rest.rounds.empty());
+    EXPECT_EQ(d.size(), 2u);
+
+    EXPECT_TRUE(d.simulate(std::nan(""), 3).rounds.empty());
+}
+
+// -------------------- Incremental combat tests --------------------
+// After a round only pairs with a newly added NPC are tested; the events
+// must still be those of a full scan over the current roster.
+
+static std::vector<NpcSpec> survivors_of(const std::vector<NpcSpec> &w, const std::vector<NamedEvent> &evs) {
+    std::vector<NpcSpec> out;
+    for (auto &s : w) {
+        bool died = std::any_of(evs.begin(), evs.end(), [&](const NamedEvent &e) { return e.victim == s.name; });
+        if (!died) out.push_back(s);
+    }
+    return out;
+}
+
+TEST(IncrementalCombatTests, NewcomersFightLikeAFullScan) {
+    auto w = random_world(11, 2000);
+    auto extra = random_world(12, 400);
+    for (auto &s : extra) s.name = "late_" + s.name;
+
+    for (unsigned threads : {1u, 3u}) {
+        Dungeon d;
+        d.setThreads(threads);
+        for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+        auto obs = std::make_shared<TestObserver>();
+        d.events().subscribe(obs);
+
+        d.runCombat(15.0);
+        auto first = brute_force_round(w, 15.0);
+        expect_same_events(obs->events, first);
+        auto world = survivors_of(w, first);
+
+        // a few arrivals per tick, at the same and at a narrower range
+        for (size_t tick = 0; tick < 4; ++tick) {
+            for (size_t k = tick * 10; k < tick * 10 + 10; ++k) {
+                d.addNPC(NPCFactory::create(extra[k].type, extra[k].name, extra[k].x, extra[k].y));
+                world.push_back(extra[k]);
+            }
+            const double range = tick % 2 ? 15.0 : 9.0;
+            obs->events.clear();
+            d.runCombat(range);
+            auto want = brute_force_round(world, range);
+            expect_same_events(obs->events, want);
+            world = survivors_of(world, want);
+            ASSERT_EQ(d.size(), world.size());
+        }
+
+        // a wider range reaches pairs no round has tested yet
+        obs->events.clear();
+        d.runCombat(40.0);
+        expect_same_events(obs->events, brute_force_round(world, 40.0));
+    }
+}
+
+TEST(IncrementalCombatTests, RemovalsAndClearKeepResultsExact) {
+    auto w = random_world(21, 800);
+    Dungeon d;
+    for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+    auto obs = std::make_shared<TestObserver>();
+    d.events().subscribe(obs);
+    d.runCombat(20.0);
+    auto world = survivors_of(w, brute_force_round(w, 20.0));
+
+    // removing NPCs only takes pairs away: the next round has nothing to do
+    for (size_t k = 0; k < world.size(); k += 7) EXPECT_TRUE(d.removeNPC(world[k].name));
+    obs->events.clear();
+    d.runCombat(20.0);
+    EXPECT_TRUE(obs->events.empty());
+
+    // after clear the world starts over
+    d.clear();
+    for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+    d.runCombat(20.0);
+    expect_same_events(obs->events, brute_force_round(w, 20.0));
+}
+
+// -------------------- Movement tests --------------------
+
+static std::vector<std::uint32_t> near_set(const SpatialGrid &g, double x, double y) {
+    std::vector<std::uint32_t> out;
+    g.forEachNear(x, y, [&](std::uint32_t idx) { out.push_back(idx); });
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+TEST(SpatialGridTests, UpdateMatchesRebuild) {
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> coord(0.0, 500.0), step(-12.0, 12.0);
+    std::vector<double> xs(3000), ys(3000);
+    for (size_t i = 0; i < xs.size(); ++i) { xs[i] = coord(rng); ys[i] = coord(rng); }
+
+    SpatialGrid g;
+    g.build(xs, ys, 10.0, 500.0);
+    for (int tick = 0; tick < 20; ++tick) {
+        // a few walkers per tick are patched in; every 5th tick everyone
+        // walks and the grid is rebuilt
+        const bool everyone = tick % 5 == 4;
+        std::vector<std::uint32_t> moved;
+        for (std::uint32_t i = 0; i < xs.size(); ++i) {
+            if (!everyone && rng() % 100) continue;
+            xs[i] = std::clamp(xs[i] + step(rng), 0.0, 500.0);
+            ys[i] = std::clamp(ys[i] + step(rng), 0.0, 500.0);
+            moved.push_back(i);
+        }
+        EXPECT_EQ(g.update(xs, ys, moved), !everyone);
+
+        SpatialGrid fresh;
+        fresh.build(xs, ys, 10.0, 500.0);
+        for (size_t q = 0; q < xs.size(); q += 37)
+            ASSERT_EQ(near_set(g, xs[q], ys[q]), near_set(fresh, xs[q], ys[q])) << "tick " << tick;
+    }
+}
+
+TEST(MovementTests, StepsStayOnMapAndWithinSpeed) {
+    Dungeon d;
+    d.addNPC(NPCFactory::create("Orc", "O", 0.0, 0.0));
+    d.addNPC(NPCFactory::create("Bear", "B", 500.0, 500.0));
+    d.addNPC(NPCFactory::create("Squirrel", "S", 250.0, 0.0));
+
+    RandomWalk walk(3);
+    for (int tick = 0; tick < 50; ++tick) {
+        std::map<std::string, std::pair<double, double>> before;
+        for (const char *name : {"O", "B", "S"}) before[name] = {d.find(name)->x(), d.find(name)->y()};
+        d.move(walk);
+        for (const char *name : {"O", "B", "S"}) {
+            const NPCBase *npc = d.find(name);
+            EXPECT_GE(npc->x(), 0.0); EXPECT_LE(npc->x(), 500.0);
+            EXPECT_GE(npc->y(), 0.0); EXPECT_LE(npc->y(), 500.0);
+            const double dist = std::hypot(npc->x() - before[name].first, npc->y() - before[name].second);
+            EXPECT_LE(dist, moveDistance(npc->kind()) + 1e-9);
+        }
+    }
+}
+
+// every NPC steps `step` along x, turning around each tick
+struct Pacing : IMovementPolicy {
+    double step;
+    explicit Pacing(double step) : step(step) {}
+    void steps(const MoveContext &ctx, std::span<double> dx, std::span<double>) override {
+        for (size_t i = 0; i < ctx.kind.size(); ++i) dx[i] = step;
+        step = -step;
+    }
+};
+
+TEST(MovementTests, LongStepsAreShortenedToTheKindsSpeed) {
+    Dungeon d;
+    d.addNPC(NPCFactory::create("Orc", "O", 100.0, 100.0));
+    d.addNPC(NPCFactory::create("Squirrel", "S", 100.0, 300.0));
+    Pacing far(100.0);
+    EXPECT_EQ(d.move(far), 2u);
+    EXPECT_DOUBLE_EQ(d.find("O")->x(), 100.0 + moveDistance(NPCKind::Orc));
+    EXPECT_DOUBLE_EQ(d.find("S")->x(), 100.0 + moveDistance(NPCKind::Squirrel));
+    EXPECT_DOUBLE_EQ(d.find("S")->y(), 300.0);
+}
+
+TEST(SimulationTests, MovementNeedsARoundCapAndStillnessEndsIt) {
+    Dungeon d;
+    d.addNPC(NPCFactory::create("Orc", "O", 100.0, 100.0));
+    d.addNPC(NPCFactory::create("Bear", "B", 400.0, 400.0));
+    Pacing pacing(1.0);   // never brings them within range
+    EXPECT_THROW(d.simulate(5.0, Dungeon::untilStable, &pacing), std::invalid_argument);
+    SimulationResult res = d.simulate(5.0, 50, &pacing);
+    EXPECT_FALSE(res.stable);
+    EXPECT_EQ(res.rounds.size(), 50u);
+
+    // nobody moves and nobody dies: nothing can change any more
+    Pacing still(0.0);
+    res = d.simulate(5.0, 50, &still);
+    EXPECT_TRUE(res.stable);
+    EXPECT_EQ(res.rounds.size(), 1u);
+    EXPECT_EQ(d.size(), 2u);
+}
+
+TEST(MovementTests, CombatAfterMovesMatchesBruteForce) {
+    auto w = random_world(31, 1500);
+    Dungeon d;
+    for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+    auto obs = std::make_shared<TestObserver>();
+    d.events().subscribe(obs);
+
+    d.runCombat(8.0);
+    auto world = survivors_of(w, brute_force_round(w, 8.0));
+    RandomWalk walk(5);
+    for (int tick = 0; tick < 6; ++tick) {
+        EXPECT_GT(d.move(walk), 0u);
+        for (auto &s : world) {
+            const NPCBase *npc = d.find(s.name);
+            ASSERT_NE(npc, nullptr);
+            s.x = npc->x();
+            s.y = npc->y();
+        }
+        obs->events.clear();
+        d.runCombat(8.0);
+        auto want = brute_force_round(world, 8.0);
+        expect_same_events(obs->events, want);
+        world = survivors_of(world, want);
+    }
+
+    // with movement a quiet round does not end the battle
+    SimulationResult res = d.simulate(8.0, 5, &walk);
+    if (!res.stable) EXPECT_EQ(res.rounds.size(), 5u);
+    for (const CombatRound &r : res.rounds) EXPECT_GT(r.moved, 0u);
+}
+
+// -------------------- Combat stats tests --------------------
+
+TEST(CombatStatsTests, CountsMatchBruteForceAndOffMeansZero) {
+    auto w = random_world(41, 1200);
+    const double range = 12.0;
+    std::uint64_t inRange = 0, relations = 0;
+    for (size_t i = 0; i < w.size(); ++i) {
+        for (size_t j = i + 1; j < w.size(); ++j) {
+            const double dx = w[i].x - w[j].x, dy = w[i].y - w[j].y;
+            if (dx*dx + dy*dy > range * range) continue;
+            const NPCKind a = kindFromName(w[i].type), b = kindFromName(w[j].type);
+            if (!canFight(a, b)) continue;   // never looked at
+            ++inRange;
+            relations += kills(a, b) + kills(b, a);
+        }
+    }
+    const size_t deaths = brute_force_round(w, range).size();
+
+    for (unsigned threads : {1u, 4u}) {
+        Dungeon d;
+        d.setThreads(threads);
+        for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+        EXPECT_FALSE(d.statsEnabled());
+        d.enableStats(true);
+        d.runCombat(range);
+
+        const CombatStats &st = d.stats();
+        EXPECT_EQ(st.rounds, 1u);
+        EXPECT_EQ(st.pairsInRange, inRange);
+        EXPECT_GE(st.pairsExamined, inRange);
+        EXPECT_EQ(st.kills, relations);
+        EXPECT_EQ(st.events, deaths);
+        EXPECT_EQ(st.removed, deaths);
+        EXPECT_GT(st.scanNs, 0u);
+
+        d.resetStats();
+        d.enableStats(false);
+        d.addNPC(NPCFactory::create("Orc", "late", 1.0, 1.0));
+        d.runCombat(range);
+        EXPECT_EQ(d.stats().rounds, 0u);
+        EXPECT_EQ(d.stats().pairsExamined, 0u);
+        EXPECT_EQ(d.stats().scanNs, 0u);
+    }
+}
+
+TEST(CombatStatsTests, SpeciesThatCannotFightAreNeverTested) {
+    // Squirrels and Bears only: Squirrel-Squirrel and Bear-Bear pairs are
+    // never distance-tested, Bear-Squirrel pairs only from the Bear side
+    auto w = random_world(43, 3000, 100.0);
+    for (size_t i = 0; i < w.size(); ++i) w[i].type = i % 50 == 0 ? "Bear" : "Squirrel";
+    Dungeon d;
+    for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y));
+    d.enableStats(true);
+    auto obs = std::make_shared<TestObserver>();
+    d.events().subscribe(obs);
+    d.runCombat(5.0);
+    expect_same_events(obs->events, brute_force_round(w, 5.0));
+    EXPECT_FALSE(obs->events.empty());
+    // fewer candidates than a species-blind scan has pairs in range
+    std::uint64_t inRange = 0;
+    for (size_t i = 0; i < w.size(); ++i)
+        for (size_t j = i + 1; j < w.size(); ++j)
+            inRange += (w[i].x - w[j].x) * (w[i].x - w[j].x) + (w[i].y - w[j].y) * (w[i].y - w[j].y) <= 25.0;
+    EXPECT_LT(d.stats().pairsExamined, inRange);
+
+    Dungeon squirrels;
+    for (int i = 0; i < 1000; ++i) squirrels.addNPC(NPCFactory::create("Squirrel", "s" + std::to_string(i), i % 100, i / 10));
+    squirrels.enableStats(true);
+    squirrels.runCombat(50.0);
+    EXPECT_EQ(squirrels.stats().pairsExamined, 0u);
+    EXPECT_EQ(squirrels.size(), 1000u);
+}
+
+// -------------------- World generator tests --------------------
+
+TEST(GeneratorTests, SameSeedSameWorldAndFileMatchesBulk) {
+    WorldSpec spec;
+    spec.count = 5000;
+    spec.seed = 77;
+    spec.distribution = WorldDistribution::Clusters;
+    spec.clusters = 5;
+    spec.spread = 30.0;
+
+    Dungeon a, b, fromFile;
+    EXPECT_EQ(a.generate(spec), spec.count);
+    EXPECT_EQ(b.generate(spec), spec.count);
+    // the names are taken now, so a second run adds nothing
+    EXPECT_EQ(b.generate(spec), 0u);
+
+    ASSERT_TRUE(writeRoster(spec, "test_generated.txt"));
+    ASSERT_TRUE(fromFile.loadFromFile("test_generated.txt"));
+    ASSERT_EQ(fromFile.size(), spec.count);
+
+    for (size_t k = 0; k < spec.count; k += 97) {
+        const std::string name = generatedName(spec, k);
+        const NPCBase *x = a.find(name), *y = b.find(name), *z = fromFile.find(name);
+        ASSERT_TRUE(x && y && z);
+        EXPECT_EQ(x->type(), z->type());
+        EXPECT_EQ(x->x(), y->x());
+        EXPECT_EQ(x->x(), z->x());   // to_chars text parses back exactly
+        EXPECT_EQ(x->y(), z->y());
+        EXPECT_GE(x->x(), 0.0); EXPECT_LE(x->x(), 500.0);
+        EXPECT_GE(x->y(), 0.0); EXPECT_LE(x->y(), 500.0);
+    }
+    fs::remove("test_generated.txt");
+
+    spec.seed = 78;
+    Dungeon c;
+    c.generate(spec);
+    EXPECT_NE(c.find(generatedName(spec, 0))->x(), a.find(generatedName(spec, 0))->x());
+}
+
+TEST(GeneratorTests, SpeciesRatio) {
+    WorldSpec spec;
+    spec.count = 20000;
+    spec.ratio = {3.0, 1.0, 0.0};
+    std::map<NPCKind, size_t> seen;
+    WorldGenerator gen(spec);
+    GeneratedNPC g;
+    while (gen.next(g)) ++seen[g.kind];
+    EXPECT_EQ(seen[NPCKind::Squirrel], 0u);
+    EXPECT_NEAR(static_cast<double>(seen[NPCKind::Orc]) / spec.count, 0.75, 0.02);
+    EXPECT_NEAR(static_cast<double>(seen[NPCKind::Bear]) / spec.count, 0.25, 0.02);
+}
+
+// -------------------- Tombstone tests --------------------
+
+TEST(TombstoneTests, DeadStayAsTombstonesUntilCompaction) {
+    auto w = random_world(51, 1200);
+    for (double threshold : {0.0, 0.25, 1.0}) {
+        Dungeon d;
+        d.setCompactionThreshold(threshold);
+        for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y, d.pool()));
+        auto obs = std::make_shared<TestObserver>();
+        d.events().subscribe(obs);
+        auto world = w;
+
+        // several rounds with arrivals and removals; the outcome must not
+        // depend on when tombstones are dropped
+        for (int tick = 0; tick < 4; ++tick) {
+            obs->events.clear();
+            d.runCombat(4.0 + tick);
+            auto want = brute_force_round(world, 4.0 + tick);
+            expect_same_events(obs->events, want);
+            world = survivors_of(world, want);
+            ASSERT_EQ(d.size(), world.size());
+
+            ASSERT_TRUE(d.removeNPC(world.front().name));
+            world.erase(world.begin());
+            // a killed NPC's name is free for a newcomer
+            const std::string reused = want.empty() ? "fresh" + std::to_string(tick) : want.front().victim;
+            EXPECT_EQ(d.find(reused), nullptr);
+            ASSERT_TRUE(d.addNPC(NPCFactory::create("Squirrel", reused, 250.0, 250.0 + tick, d.pool())));
+            world.push_back({"Squirrel", reused, 250.0, 250.0 + tick});
+        }
+
+        d.saveToFile("test_tombs.txt");
+        d.saveBinary("test_tombs.bin");
+        Dungeon text, bin;
+        text.loadFromFile("test_tombs.txt");
+        bin.loadBinary("test_tombs.bin");
+        EXPECT_EQ(text.size(), world.size());
+        EXPECT_EQ(bin.size(), world.size());
+        for (auto &s : world) {
+            ASSERT_NE(bin.find(s.name), nullptr) << s.name;
+            EXPECT_EQ(bin.find(s.name)->x(), d.find(s.name)->x());
+        }
+
+        d.compact();
+        EXPECT_EQ(d.size(), world.size());
+        for (auto &s : world) EXPECT_NE(d.find(s.name), nullptr);
+    }
+    fs::remove("test_tombs.txt");
+    fs::remove("test_tombs.bin");
+}
+
+// -------------------- NPC handle tests --------------------
+
+// resolves every event's names through the dungeon while it is delivered
+struct HandleObserver : public IObserver {
+    const Dungeon *d = nullptr;
+    std::vector<DeathEvent> events;
+    std::vector<std::string> victims;
+    void onDeath(const DeathEvent &ev, const INameSource &names) override {
+        events.push_back(ev);
+        victims.emplace_back(names.nameOf(ev.victim));
+        EXPECT_EQ(d->nameOf(ev.victim), names.nameOf(ev.victim));
+        EXPECT_EQ(d->find(ev.killer)->name(), names.nameOf(ev.killer));
+    }
+};
+
+TEST(HandleTests, HandlesSurviveCompactionAndGoStaleAfterIt) {
+    Dungeon d;
+    d.setCompactionThreshold(1.0);   // compact only on request
+    for (int i = 0; i < 100; ++i)
+        d.addNPC(NPCFactory::create("Squirrel", "s" + std::to_string(i), i, i, d.pool()));
+    const NPCHandle h = d.handleOf("s70");
+    ASSERT_TRUE(h);
+    EXPECT_FALSE(d.handleOf("nobody"));
+    EXPECT_EQ(d.nameOf(h), "s70");
+
+    for (int i = 0; i < 70; i += 2) ASSERT_TRUE(d.removeNPC("s" + std::to_string(i)));
+    const NPCHandle gone = d.handleOf("s71");
+    ASSERT_TRUE(d.removeNPC("s71"));
+    EXPECT_EQ(d.find(gone), nullptr);
+    EXPECT_EQ(d.nameOf(gone), "s71");   // the tombstone keeps its name
+    ASSERT_TRUE(d.addNPC(NPCFactory::create("Orc", "s71", 1, 1, d.pool())));
+    EXPECT_NE(d.handleOf("s71"), gone);
+
+    d.compact();
+    EXPECT_EQ(d.handleOf("s70"), h);
+    ASSERT_NE(d.find(h), nullptr);
+    EXPECT_EQ(d.find(h)->name(), "s70");
+    EXPECT_DOUBLE_EQ(d.find(h)->x(), 70.0);
+    EXPECT_EQ(d.nameOf(gone), "");
+    EXPECT_EQ(d.find(d.handleOf("s71"))->type(), "Orc");
+
+    // new NPCs reuse freed entries under a new generation
+    ASSERT_TRUE(d.addNPC(NPCFactory::create("Bear", "late", 5, 5, d.pool())));
+    EXPECT_EQ(d.nameOf(gone), "");
+    d.clear();
+    EXPECT_EQ(d.nameOf(h), "");
+    EXPECT_EQ(d.find(h), nullptr);
+}
+
+TEST(HandleTests, EventsCarryHandlesThatResolveDuringDelivery) {
+    auto w = random_world(61, 1500);
+    Dungeon d;
+    for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y, d.pool()));
+    auto obs = std::make_shared<HandleObserver>();
+    obs->d = &d;
+    d.events().subscribe(obs);
+    d.runCombat(10.0);
+
+    const auto want = brute_force_round(w, 10.0);
+    ASSERT_EQ(obs->victims.size(), want.size());
+    ASSERT_FALSE(want.empty());
+    for (size_t k = 0; k < want.size(); ++k) EXPECT_EQ(obs->victims[k], want[k].victim);
+    for (auto &ev : obs->events) EXPECT_EQ(d.find(ev.victim), nullptr);
+    d.compact();
+    for (auto &ev : obs->events) EXPECT_EQ(d.nameOf(ev.victim), "");
+}
+
+// -------------------- Combat sweep tests --------------------
+
+static std::vector<NamedEvent> named_sweep(const CombatSweep &sweep, const Dungeon &d) {
+    std::vector<NamedEvent> evs;
+    for (auto &ev : sweep.events)
+        evs.push_back({std::string(d.nameOf(ev.killer)), std::string(d.nameOf(ev.victim)), ev.x, ev.y});
+    return evs;
+}
+
+TEST(SweepTests, EveryRangeMatchesItsOwnRound) {
+    auto w = random_world(77, 2000);
+    const std::vector<double> ranges = {40.0, 0.0, 3.0, 12.5, -1.0, 7.0, 12.5, 100.0};
+    for (unsigned threads : {1u, 4u}) {
+        Dungeon d;
+        d.setThreads(threads);
+        for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y, d.pool()));
+        const auto sweep = d.sweepCombat(ranges);
+        ASSERT_EQ(sweep.size(), ranges.size());
+        EXPECT_EQ(d.size(), w.size());   // nobody died
+        for (size_t k = 0; k < ranges.size(); ++k) {
+            EXPECT_EQ(sweep[k].range, ranges[k]);
+            if (ranges[k] < 0) EXPECT_TRUE(sweep[k].events.empty());
+            else expect_same_events(named_sweep(sweep[k], d), brute_force_round(w, ranges[k]));
+        }
+
+        // the dungeon still fights as if the sweep never ran
+        const auto want = named_sweep(sweep[3], d);   // before the dead are compacted away
+        auto obs = std::make_shared<TestObserver>();
+        d.events().subscribe(obs);
+        d.runCombat(12.5);
+        expect_same_events(obs->events, want);
+    }
+}
+
+TEST(SweepTests, SkipsTheDeadAndMatchesCopies) {
+    const std::string fname = "ut_test_sweep.bin";
+    auto w = random_world(78, 1500);
+    Dungeon d;
+    d.setCompactionThreshold(1.0);   // keep the tombstones around
+    for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y, d.pool()));
+    d.runCombat(4.0);
+    for (size_t i = 0; i < w.size(); i += 7) d.removeNPC(w[i].name);
+    ASSERT_TRUE(d.saveBinary(fname));
+
+    const std::vector<double> ranges = {2.0, 4.0, 9.0, 25.0};
+    const auto sweep = d.sweepCombat(ranges);
+    for (size_t k = 0; k < ranges.size(); ++k) {
+        Dungeon copy;
+        ASSERT_TRUE(copy.loadBinary(fname));
+        auto obs = std::make_shared<TestObserver>();
+        copy.events().subscribe(obs);
+        copy.runCombat(ranges[k]);
+        // the survivors of the first round at range 4 are at peace up to 4
+        if (ranges[k] <= 4.0) EXPECT_TRUE(obs->events.empty());
+        expect_same_events(named_sweep(sweep[k], d), obs->events);
+    }
+    EXPECT_FALSE(sweep.back().events.empty());
+    std::error_code ec;
+    fs::remove(fname, ec);
+}
+
+TEST(SweepTests, ConcurrentSweepsOnOneDungeonAgree) {
+    auto w = random_world(79, 3000);
+    Dungeon d;
+    d.setThreads(4);
+    for (auto &s : w) d.addNPC(NPCFactory::create(s.type, s.name, s.x, s.y, d.pool()));
+    const std::vector<double> ranges = {2.0, 6.0, 15.0};
+    const auto want = d.sweepCombat(ranges);
+
+    const Dungeon &cd = d;
+    std::vector<std::vector<CombatSweep>> got(4);
+    std::vector<std::thread> callers;
+    for (auto &g : got) callers.emplace_back([&] { for (int k = 0; k < 5; ++k) g = cd.sweepCombat(ranges); });
+    for (auto &t : callers) t.join();
+    for (auto &g : got) {
+        ASSERT_EQ(g.size(), want.size());
+        for (size_t k = 0; k < want.size(); ++k)
+            expect_same_events(named_sweep(g[k], d), named_sweep(want[k], d));
+    }
+}